@@ -0,0 +1,105 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "../include/lexer.h"
+#include "../include/parser.h"
+
+// Mede o custo de despachar cada nó da AST: a cadeia de dynamic_cast que os
+// passos usavam contra o switch na tag NodeKind (visitNode/forEachChild).
+// Os dois percursos somam os literais e contam os nós, então fazem o mesmo
+// trabalho por nó e devem dar o mesmo resultado.
+static std::string buildProgram(int statements) {
+    std::mt19937 rng(7);
+    std::ostringstream src;
+    src << "funcao f(a, b) = a * b + 1\n";
+    for (int i = 0; i < statements; ++i) {
+        src << "x" << i % 64 << " = ";
+        int terms = 4 + static_cast<int>(rng() % 8);
+        for (int t = 0; t < terms; ++t) {
+            if (t > 0) src << " " << "+-*/"[rng() % 4] << " ";
+            switch (rng() % 4) {
+                case 0: src << rng() % 100; break;
+                case 1: src << "-(" << rng() % 10 << " ^ 2)"; break;
+                case 2: src << "f(" << rng() % 10 << ", 2.5)"; break;
+                default: src << "(1.5 + " << rng() % 10 << ")"; break;
+            }
+        }
+        src << "\n";
+    }
+    return src.str();
+}
+
+struct Tally {
+    size_t nodes = 0;
+    double sum = 0.0;
+};
+
+static void walkDynamic(const Node *node, Tally &tally) {
+    if (!node) return;
+    ++tally.nodes;
+
+    if (auto num = dynamic_cast<const NumberNode*>(node)) {
+        tally.sum += num->number();
+    } else if (dynamic_cast<const VarNode*>(node)) {
+    } else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        walkDynamic(binary->left.get(), tally);
+        walkDynamic(binary->right.get(), tally);
+    } else if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        walkDynamic(unary->operand.get(), tally);
+    } else if (auto call = dynamic_cast<const FuncCallNode*>(node)) {
+        for (const auto &arg : call->args) walkDynamic(arg.get(), tally);
+    } else if (auto assign = dynamic_cast<const AssignNode*>(node)) {
+        walkDynamic(assign->expr.get(), tally);
+    } else if (auto decl = dynamic_cast<const FuncDeclNode*>(node)) {
+        walkDynamic(decl->body.get(), tally);
+    }
+}
+
+static void walkTagged(const Node *node, Tally &tally) {
+    ++tally.nodes;
+    if (auto num = nodeAs<NumberNode>(node)) tally.sum += num->number();
+    forEachChild(*node, [&](const NodePtr &child) { walkTagged(child.get(), tally); });
+}
+
+template<typename Walk>
+static double timeWalk(const std::vector<NodePtr> &ast, int repeats, Walk walk, Tally &tally) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        tally = Tally();
+        for (const auto &node : ast) walk(node.get(), tally);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    int statements = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::string source = buildProgram(statements);
+    Lexer lexer(source);
+    Arena arena;
+    Parser parser(lexer, arena);
+    auto ast = parser.parseAll();
+
+    Tally dynamic, tagged;
+    timeWalk(ast, 1, walkDynamic, dynamic);
+    double dynamicTime = timeWalk(ast, repeats, walkDynamic, dynamic);
+    double taggedTime = timeWalk(ast, repeats, walkTagged, tagged);
+
+    if (dynamic.nodes != tagged.nodes || dynamic.sum != tagged.sum) {
+        std::cerr << "percursos divergem: " << dynamic.nodes << " x " << tagged.nodes << " nós\n";
+        return 1;
+    }
+
+    double visits = static_cast<double>(dynamic.nodes) * repeats;
+    std::cout << dynamic.nodes << " nós, " << repeats << " repetições\n";
+    std::cout << "dynamic_cast: " << dynamicTime * 1e3 << " ms  ("
+              << dynamicTime * 1e9 / visits << " ns/nó)\n";
+    std::cout << "tag NodeKind: " << taggedTime * 1e3 << " ms  ("
+              << taggedTime * 1e9 / visits << " ns/nó)  speedup "
+              << dynamicTime / taggedTime << "x\n";
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/semantic.h"
+#include "../include/codegen.h"
+#include "../include/batch.h"
+
+// Avalia calc(a, b, c) sobre colunas aleatórias com cada nível de kernel
+// disponível e confere que todos produzem os mesmos bits do escalar.
+static const char *SOURCE =
+    "funcao calc(a, b, c) = (a + b) * c / (a - b) + a * a - -c\n";
+
+static bool sameBits(const std::vector<double> &x, const std::vector<double> &y) {
+    return std::memcmp(x.data(), y.data(), x.size() * sizeof(double)) == 0;
+}
+
+int main(int argc, char **argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 4000000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    Lexer lexer(SOURCE);
+    Arena arena;
+    Parser parser(lexer, arena);
+    auto ast = parser.parseAll();
+    SemanticAnalyzer sem;
+    sem.analyze(ast);
+    CodeGenerator codegen;
+    codegen.generateCode(ast);
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> dist(-100.0, 100.0);
+    std::vector<std::vector<double>> columns(3, std::vector<double>(rows));
+    for (auto &column : columns) {
+        for (auto &v : column) v = std::round(dist(rng));
+    }
+    std::vector<const double*> inputs = {columns[0].data(), columns[1].data(), columns[2].data()};
+
+    BatchEvaluator batch(codegen.getProgram(), {});
+    uint32_t calc = BatchEvaluator::functionIndex(codegen.getProgram(), "calc");
+    SimdLevel best = batch.getSimdLevel();
+
+    std::vector<double> reference;
+    double scalarTime = 0.0;
+    for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (static_cast<int>(level) > static_cast<int>(best)) {
+            std::cout << simdLevelName(level) << ": indisponível nesta CPU\n";
+            continue;
+        }
+        batch.setSimdLevel(level);
+
+        std::vector<double> out(rows);
+        batch.evaluate(calc, inputs, rows, out.data());
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i) batch.evaluate(calc, inputs, rows, out.data());
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << simdLevelName(level) << ": " << elapsed * 1e3 << " ms  ("
+                  << elapsed * 1e9 / (static_cast<double>(rows) * repeats) << " ns/linha)";
+        if (level == SimdLevel::SCALAR) {
+            reference = out;
+            scalarTime = elapsed;
+            std::cout << "\n";
+        } else {
+            std::cout << "  speedup " << scalarTime / elapsed << "x\n";
+            if (!sameBits(out, reference)) {
+                std::cerr << "resultados do kernel " << simdLevelName(level) << " divergem do escalar\n";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/semantic.h"
+#include "../include/codegen.h"
+#include "../include/interpreter.h"
+
+// Compara o laço com switch e o despacho threaded (computed goto) do
+// interpretador. Cada f_k chama f_{k-1} duas vezes, então executar f_K
+// faz 2^(K+1) - 1 chamadas.
+static std::string buildProgram(int depth) {
+    std::ostringstream src;
+    src << "funcao f0(a, b) = (a + b) * 0.5 - a / (b + 1)\n";
+    for (int k = 1; k <= depth; ++k) {
+        src << "funcao f" << k << "(a, b) = f" << k - 1 << "(a, b) + f" << k - 1 << "(b, a) * 0.25\n";
+    }
+    src << "x = f" << depth << "(1.5, 2.5)\n";
+    return src.str();
+}
+
+static double timeMode(Interpreter &interp, DispatchMode mode, int repeats) {
+    interp.setDispatchMode(mode);
+    interp.runProgram();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) interp.runProgram();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+    int depth = argc > 1 ? std::stoi(argv[1]) : 18;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::string source = buildProgram(depth);
+    Lexer lexer(source);
+    Arena arena;
+    Parser parser(lexer, arena);
+    auto ast = parser.parseAll();
+    SemanticAnalyzer sem;
+    sem.analyze(ast);
+    CodeGenerator codegen;
+    codegen.generateCode(ast);
+
+    Interpreter interp(codegen.getProgram());
+    interp.setTrace(false);
+
+    double calls = static_cast<double>((1ull << (depth + 1)) - 1) * repeats;
+
+    double switchTime = timeMode(interp, DispatchMode::SWITCH, repeats);
+    double switchResult = interp.getGlobals()[0];
+    std::cout << "switch:   " << switchTime * 1e3 << " ms  ("
+              << switchTime * 1e9 / calls << " ns/chamada)\n";
+
+    interp.setDispatchMode(DispatchMode::THREADED);
+    if (interp.getDispatchMode() != DispatchMode::THREADED) {
+        std::cout << "threaded: indisponível (compilado sem computed goto)\n";
+        return 0;
+    }
+
+    double threadedTime = timeMode(interp, DispatchMode::THREADED, repeats);
+    std::cout << "threaded: " << threadedTime * 1e3 << " ms  ("
+              << threadedTime * 1e9 / calls << " ns/chamada)\n";
+    std::cout << "speedup:  " << switchTime / threadedTime << "x\n";
+
+    if (interp.getGlobals()[0] != switchResult) {
+        std::cerr << "resultados divergentes entre os modos de despacho\n";
+        return 1;
+    }
+
+    Interpreter jitInterp(codegen.getProgram());
+    jitInterp.setTrace(false);
+    if (jitInterp.enableJit() == 0) {
+        std::cout << "jit:      indisponível nesta plataforma\n";
+        return 0;
+    }
+
+    jitInterp.runProgram();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) jitInterp.runProgram();
+    double jitTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "jit:      " << jitTime * 1e3 << " ms  ("
+              << jitTime * 1e9 / calls << " ns/chamada)\n";
+
+    if (jitInterp.getGlobals()[0] != switchResult) {
+        std::cerr << "resultado do JIT diverge do interpretador\n";
+        return 1;
+    }
+    return 0;
+}
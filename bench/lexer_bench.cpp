@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../include/lexer.h"
+
+// Vazão do lexer sobre um código gerado de alguns MB, comparada com uma
+// passada que só lê a memória (contar '\n'), que serve de teto. Mede o modo
+// que o parser usa (next(), um token por vez) e o vetor de tokenize().
+static std::string buildSource(size_t bytes) {
+    std::mt19937 rng(3);
+    std::string src;
+    src.reserve(bytes + 128);
+    src += "funcao media(a, b) = (a + b) / 2\n";
+    while (src.size() < bytes) {
+        src += "valor_" + std::to_string(rng() % 1000) + " = media(" + std::to_string(rng() % 100000) +
+               ".25, total_" + std::to_string(rng() % 50) + ") * -" + std::to_string(rng() % 10) +
+               " ^ 2 - (x + 3)\n";
+    }
+    return src;
+}
+
+template<typename Fn>
+static double bestOf(int repeats, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 64;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::string source = buildSource(megabytes << 20);
+    double mb = static_cast<double>(source.size()) / (1 << 20);
+
+    size_t lines = 0;
+    double scan = bestOf(repeats, [&] { lines = std::count(source.begin(), source.end(), '\n'); });
+
+    size_t tokens = 0;
+    double pull = bestOf(repeats, [&] {
+        Lexer lexer(source);
+        tokens = 1;
+        while (lexer.next().type != TokenType::END_OF_FILE) ++tokens;
+    });
+    double vector = bestOf(repeats, [&] {
+        Lexer lexer(source);
+        tokens = lexer.tokenize().size();
+    });
+
+    std::cout << mb << " MB, " << lines << " linhas, " << tokens << " tokens\n";
+    std::cout << "leitura:    " << mb / scan << " MB/s\n";
+    std::cout << "next():     " << mb / pull << " MB/s  (" << pull * 1e9 / tokens << " ns/token)\n";
+    std::cout << "tokenize(): " << mb / vector << " MB/s  (" << vector * 1e9 / tokens << " ns/token)\n";
+    return 0;
+}
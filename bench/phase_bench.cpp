@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/semantic.h"
+#include "../include/codegen.h"
+#include "../include/interpreter.h"
+#include "../include/trace.h"
+
+// Tempo de cada fase do pipeline sobre programas sintéticos que crescem com
+// a escala: expressões profundas, muitas funções, cadeias longas de chamadas
+// e listas largas de argumentos. Cada repetição refaz o pipeline inteiro e
+// mede cada fase à parte; o parser puxa os tokens do lexer, então parseAll
+// inclui a tokenização. Com --json a saída é um objeto JSON, para comparar
+// as fases entre versões.
+struct Workload {
+    std::string name;
+    std::string source;
+    size_t statements = 0;
+};
+
+static std::string nested(int depth, int seed) {
+    std::string expr = std::to_string(seed % 97 + 1);
+    static const char *ops[] = {" + ", " * ", " - ", " / "};
+    for (int d = 0; d < depth; ++d) {
+        expr = "(" + expr + ops[d % 4] + std::to_string((seed + d) % 13 + 1) + ")";
+    }
+    return expr;
+}
+
+// Atribuições com expressões de 128 níveis de parênteses.
+static Workload deepExpressions(size_t scale) {
+    Workload w{"expressoes_profundas", "", scale};
+    for (size_t i = 0; i < scale; ++i) {
+        w.source += "e" + std::to_string(i) + " = " + nested(128, static_cast<int>(i)) + "\n";
+    }
+    return w;
+}
+
+// Funções independentes de dois parâmetros, cada uma chamada por uma global.
+static Workload manyFunctions(size_t scale) {
+    Workload w{"muitas_funcoes", "", 2 * scale};
+    for (size_t i = 0; i < scale; ++i) {
+        std::string f = "f" + std::to_string(i);
+        w.source += "funcao " + f + "(a, b) = a * b + " + std::to_string(i % 100) + " - a / (b + 1)\n";
+        w.source += "v" + std::to_string(i) + " = " + f + "(" + std::to_string(i % 10) + ", 2.5)\n";
+    }
+    return w;
+}
+
+// Cadeias de 500 funções em que cada uma chama a anterior; uma global chama
+// a última de cada cadeia.
+static Workload callChains(size_t scale) {
+    constexpr size_t CHAIN = 500;
+    Workload w{"cadeias_de_chamadas", "", 0};
+    for (size_t i = 0; i < scale; ++i) {
+        std::string f = "c" + std::to_string(i);
+        if (i % CHAIN == 0) w.source += "funcao " + f + "(n) = n + 1\n";
+        else w.source += "funcao " + f + "(n) = c" + std::to_string(i - 1) + "(n) * 1.0001 + 1\n";
+        ++w.statements;
+        if (i % CHAIN == CHAIN - 1 || i + 1 == scale) {
+            w.source += "r" + std::to_string(i / CHAIN) + " = " + f + "(" + std::to_string(i % 7) + ")\n";
+            ++w.statements;
+        }
+    }
+    return w;
+}
+
+// Funções de 32 parâmetros chamadas com 32 argumentos.
+static Workload wideArguments(size_t scale) {
+    constexpr int WIDTH = 32;
+    Workload w{"argumentos_largos", "", 0};
+    std::string params, body;
+    for (int p = 0; p < WIDTH; ++p) {
+        std::string name = "p" + std::to_string(p);
+        params += (p ? ", " : "") + name;
+        body += (p ? (p % 2 ? " + " : " * ") : "") + name;
+    }
+    for (size_t i = 0; i < scale / 4; ++i) {
+        std::string f = "w" + std::to_string(i);
+        std::string args;
+        for (int p = 0; p < WIDTH; ++p) args += (p ? ", " : "") + std::to_string((i + p) % 9 + 1);
+        w.source += "funcao " + f + "(" + params + ") = " + body + "\n";
+        w.source += "a" + std::to_string(i) + " = " + f + "(" + args + ")\n";
+        w.statements += 2;
+    }
+    return w;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static const char *PHASES[] = {"tokenize", "parseAll", "analyze", "generateCode", "execute"};
+constexpr size_t PHASE_COUNT = 5;
+
+struct WorkloadResult {
+    const Workload *workload = nullptr;
+    size_t tokens = 0;
+    size_t instructions = 0;
+    std::vector<double> phases[PHASE_COUNT];   // segundos, em ordem crescente
+};
+
+template<typename Fn>
+static double seconds(Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static WorkloadResult measure(const Workload &w, int repeats) {
+    WorkloadResult result;
+    result.workload = &w;
+
+    for (int r = 0; r < repeats; ++r) {
+        result.phases[0].push_back(seconds([&] {
+            Lexer lexer(w.source);
+            result.tokens = lexer.tokenize().size();
+        }));
+
+        Arena arena;
+        std::vector<NodePtr> ast;
+        result.phases[1].push_back(seconds([&] {
+            Lexer lexer(w.source);
+            Parser parser(lexer, arena);
+            ast = parser.parseAll();
+        }));
+
+        SemanticAnalyzer sem;
+        result.phases[2].push_back(seconds([&] { sem.analyze(ast); }));
+
+        CodeGenerator codegen;
+        result.phases[3].push_back(seconds([&] { codegen.generateCode(ast); }));
+
+        const Program &program = codegen.getProgram();
+        result.instructions = program.main.code.size();
+        for (const auto &fn : program.functions) result.instructions += fn.code.size();
+
+        Interpreter interpreter(program);
+        interpreter.setTrace(false);
+        result.phases[4].push_back(seconds([&] { interpreter.execute(); }));
+    }
+    for (auto &phase : result.phases) std::sort(phase.begin(), phase.end());
+    return result;
+}
+
+static void printText(const std::vector<WorkloadResult> &results) {
+    for (const auto &result : results) {
+        const Workload &w = *result.workload;
+        double mb = static_cast<double>(w.source.size()) / (1 << 20);
+        std::cout << w.name << ": " << mb << " MB, " << w.statements << " comandos, "
+                  << result.tokens << " tokens, " << result.instructions << " instruções\n";
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            const auto &samples = result.phases[p];
+            double median = percentile(samples, 50);
+            std::cout << "  " << PHASES[p] << std::string(14 - std::strlen(PHASES[p]), ' ')
+                      << "p50 " << median * 1e3 << " ms, p90 " << percentile(samples, 90) * 1e3
+                      << " ms, p99 " << percentile(samples, 99) * 1e3 << " ms  ("
+                      << mb / median << " MB/s, " << result.tokens / median << " tokens/s)\n";
+        }
+    }
+}
+
+static void printJson(const std::vector<WorkloadResult> &results, size_t scale, int repeats) {
+    std::cout << "{\n  \"scale\": " << scale << ",\n  \"repeats\": " << repeats << ",\n  \"workloads\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto &result = results[i];
+        const Workload &w = *result.workload;
+        double mb = static_cast<double>(w.source.size()) / (1 << 20);
+        std::cout << (i ? "," : "") << "\n    {\"name\": \"" << w.name << "\", \"bytes\": " << w.source.size()
+                  << ", \"statements\": " << w.statements << ", \"tokens\": " << result.tokens
+                  << ", \"instructions\": " << result.instructions << ", \"phases\": {";
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            const auto &samples = result.phases[p];
+            double median = percentile(samples, 50);
+            std::cout << (p ? "," : "") << "\n      \"" << PHASES[p] << "\": {\"min_ms\": " << samples.front() * 1e3
+                      << ", \"p50_ms\": " << median * 1e3 << ", \"p90_ms\": " << percentile(samples, 90) * 1e3
+                      << ", \"p99_ms\": " << percentile(samples, 99) * 1e3 << ", \"max_ms\": "
+                      << samples.back() * 1e3 << ", \"mb_per_s\": " << mb / median
+                      << ", \"tokens_per_s\": " << result.tokens / median << "}";
+        }
+        std::cout << "\n    }}";
+    }
+    std::cout << "\n  ]\n}\n";
+}
+
+// Inteiro positivo ocupando o argumento inteiro; 0 se não for um.
+static size_t positive(const std::string &arg) {
+    if (arg.empty() || arg.size() > 9 || arg.find_first_not_of("0123456789") != std::string::npos) return 0;
+    return std::stoul(arg);
+}
+
+int main(int argc, char **argv) {
+    size_t scale = 2000;
+    int repeats = 20;
+    bool json = false;
+    int position = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t value = positive(arg);
+        if (arg == "--json") json = true;
+        else if (value > 0 && position < 2) {
+            if (position++ == 0) scale = value;
+            else repeats = static_cast<int>(value);
+        } else {
+            std::cerr << "Argumento inválido: " << arg << "\n"
+                      << "uso: phase_bench [escala] [repetições] [--json]\n";
+            return 1;
+        }
+    }
+    Trace::setLevel(TraceLevel::QUIET);
+
+    std::vector<Workload> workloads = {deepExpressions(scale), manyFunctions(scale),
+                                       callChains(scale), wideArguments(scale)};
+    std::vector<WorkloadResult> results;
+    for (const auto &w : workloads) results.push_back(measure(w, repeats));
+
+    if (json) printJson(results, scale, repeats);
+    else printText(results);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "../include/session.h"
+#include "../include/trace.h"
+
+// Latência de uma edição na sessão (--repl) conforme ela cresce: a sessão
+// recebe n definições (funções que se chamam em cadeias de quatro e globais
+// que leem essas funções) e depois mede-se a redefinição de uma função no
+// começo de uma cadeia e a de uma global. O tempo por edição deve ficar igual
+// para qualquer n.
+static void fill(Session &session, int definitions) {
+    session.submit("base = 1");
+    for (int i = 0; i < definitions / 2; ++i) {
+        std::string f = "f" + std::to_string(i);
+        if (i % 4 == 0) session.submit("funcao " + f + "(a, b) = a * b + base");
+        else session.submit("funcao " + f + "(a, b) = f" + std::to_string(i - 1) + "(a, b) - " +
+                            std::to_string(i % 7));
+        session.submit("v" + std::to_string(i) + " = " + f + "(" + std::to_string(i % 10) + ", 2.5)");
+    }
+}
+
+template<typename Fn>
+static double perEdit(int edits, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < edits; ++i) fn(i);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e6 / edits;
+}
+
+int main(int argc, char **argv) {
+    int edits = argc > 1 ? std::stoi(argv[1]) : 2000;
+    Trace::setLevel(TraceLevel::QUIET);
+
+    for (int definitions : {100, 1000, 10000, 100000}) {
+        Session session;
+        fill(session, definitions);
+
+        // fm é chamada por fm+1 (que é chamada por fm+2): três globais a recalcular
+        int m = 4 * (definitions / 16) + 1;
+        std::string middle = std::to_string(m);
+        double function = perEdit(edits, [&](int i) {
+            session.submit("funcao f" + middle + "(a, b) = f" + std::to_string(m - 1) +
+                           "(a, b) + " + std::to_string(i % 5));
+        });
+        size_t recomputed = session.lastRecomputed();
+        double global = perEdit(edits, [&](int i) {
+            session.submit("v" + middle + " = f" + middle + "(" + std::to_string(i % 9) + ", 1.5)");
+        });
+
+        std::cout << session.definitionCount() << " definições: função " << function
+                  << " us/edição (" << recomputed << " globais recalculadas), global "
+                  << global << " us/edição\n";
+    }
+    return 0;
+}
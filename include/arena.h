@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Memória de uma compilação: blocos grandes entregues em sequência (bump
+// pointer). Nada é liberado peça por peça; tudo volta ao sistema de uma vez
+// quando a arena é destruída. Também serve de memory_resource para os
+// containers std::pmr guardados nos nós da AST.
+class Arena : public std::pmr::memory_resource {
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *cursor;
+    char *limit;
+    size_t used;
+    size_t reserved;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    Arena();
+    Arena(const Arena &) = delete;
+    Arena& operator=(const Arena &) = delete;
+
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copia o texto para a arena; a view fica válida enquanto ela existir.
+    std::string_view copy(std::string_view text);
+
+    size_t bytesUsed() const { return used; }
+    size_t bytesReserved() const { return reserved; }
+    size_t blockCount() const { return blocks.size(); }
+};
+
+#endif
@@ -1,12 +1,20 @@
 #ifndef AST_H
 #define AST_H
 
+#include <charconv>
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
-#include <iostream>
+#include "arena.h"
+#include "symbols.h"
+#include "token.h"
+#include "trace.h"
 
-enum class Type {
+enum class Type : uint8_t {
     INT,
     FLOAT,
     UNKNOWN
@@ -20,114 +28,264 @@ inline std::string typeToString(Type t) {
     }
 }
 
+enum class SlotKind : uint8_t {
+    NONE,
+    GLOBAL,
+    LOCAL
+};
+
+// Posição de um valor em tempo de execução, resolvida pela análise semântica:
+// índice na tabela de globais ou registrador do frame da função.
+struct Slot {
+    SlotKind kind = SlotKind::NONE;
+    uint32_t index = 0;
+};
+
+// Tag do tipo concreto de cada nó. Os passos despacham com switch nela
+// (visitNode, forEachChild, nodeAs) em vez de tentar dynamic_cast em cadeia.
+enum class NodeKind : uint8_t {
+    NUMBER,
+    VAR,
+    BINARY_OP,
+    UNARY_OP,
+    FUNC_CALL,
+    ASSIGN,
+    FUNC_DECL
+};
+
 struct Node {
+    explicit Node(NodeKind k): kind(k) {}
     virtual ~Node() = default;
     virtual void prettyPrint(int indent=0) const = 0;
+    const NodeKind kind;
     Type type = Type::UNKNOWN;
 };
 
-using NodePtr = std::unique_ptr<Node>;
+// Os nós vivem na Arena da compilação: o ponteiro não libera nada e a árvore
+// inteira some junto com a arena. Por isso os campos dos nós também apontam
+// para a arena (string_view, std::pmr::vector) e nenhum destrutor precisa rodar.
+struct ArenaDelete {
+    void operator()(const void *) const {}
+};
+
+template<typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete>;
+
+using NodePtr = ArenaPtr<Node>;
+
+template<typename T, typename... Args>
+ArenaPtr<T> makeNode(Arena &arena, Args&&... args) {
+    return ArenaPtr<T>(arena.make<T>(std::forward<Args>(args)...));
+}
 
 inline void printIndent(int n) {
-    for (int i=0;i<n;i++) std::cout << "  ";
+    for (int i=0;i<n;i++) Trace::out() << "  ";
 }
 
 struct NumberNode : Node {
-    std::string value;
-    NumberNode(const std::string &v): value(v) {
+    static constexpr NodeKind KIND = NodeKind::NUMBER;
+    std::string_view value;
+    NumberNode(std::string_view v): Node(KIND), value(v) {
 
-        type = (v.find('.') != std::string::npos) ? Type::FLOAT : Type::INT;
+        type = (v.find('.') != std::string_view::npos) ? Type::FLOAT : Type::INT;
+    }
+    double number() const {
+        double result = 0.0;
+        std::from_chars(value.data(), value.data() + value.size(), result);
+        return result;
     }
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
         std::string typeStr = typeToString(type);
         if (!typeStr.empty()) {
-            std::cout << "Number(" << value << " : " << typeStr << ")\n";
+            Trace::out() << "Number(" << value << " : " << typeStr << ")\n";
         } else {
-            std::cout << "Number(" << value << ")\n";
+            Trace::out() << "Number(" << value << ")\n";
         }
     }
 };
 
 struct VarNode : Node {
-    std::string name;
-    VarNode(const std::string &n): name(n) {}
+    static constexpr NodeKind KIND = NodeKind::VAR;
+    Symbol name;
+    Slot slot;
+    VarNode(Symbol n): Node(KIND), name(n) {}
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
         std::string typeStr = typeToString(type);
         if (!typeStr.empty()) {
-            std::cout << "Var(" << name << " : " << typeStr << ")\n";
+            Trace::out() << "Var(" << Symbols::name(name) << " : " << typeStr << ")\n";
         } else {
-            std::cout << "Var(" << name << ")\n";
+            Trace::out() << "Var(" << Symbols::name(name) << ")\n";
         }
     }
 };
 
 struct BinaryOpNode : Node {
-    std::string op;
+    static constexpr NodeKind KIND = NodeKind::BINARY_OP;
+    Operator op;
     NodePtr left, right;
-    BinaryOpNode(std::string o, NodePtr l, NodePtr r): op(std::move(o)), left(std::move(l)), right(std::move(r)) {}
+    Slot slot;
+    BinaryOpNode(Operator o, NodePtr l, NodePtr r): Node(KIND), op(o), left(std::move(l)), right(std::move(r)) {}
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
         std::string typeStr = typeToString(type);
         if (!typeStr.empty()) {
-            std::cout << "BinaryOp(" << op << " : " << typeStr << ")\n";
+            Trace::out() << "BinaryOp(" << operatorSymbol(op) << " : " << typeStr << ")\n";
         } else {
-            std::cout << "BinaryOp(" << op << ")\n";
+            Trace::out() << "BinaryOp(" << operatorSymbol(op) << ")\n";
         }
         if (left) left->prettyPrint(indent+1);
         if (right) right->prettyPrint(indent+1);
     }
 };
 
+struct UnaryOpNode : Node {
+    static constexpr NodeKind KIND = NodeKind::UNARY_OP;
+    Operator op;
+    NodePtr operand;
+    Slot slot;
+    UnaryOpNode(Operator o, NodePtr e): Node(KIND), op(o), operand(std::move(e)) {}
+    void prettyPrint(int indent=0) const override {
+        printIndent(indent);
+        std::string typeStr = typeToString(type);
+        if (!typeStr.empty()) {
+            Trace::out() << "UnaryOp(" << operatorSymbol(op) << " : " << typeStr << ")\n";
+        } else {
+            Trace::out() << "UnaryOp(" << operatorSymbol(op) << ")\n";
+        }
+        if (operand) operand->prettyPrint(indent+1);
+    }
+};
+
 struct FuncCallNode : Node {
-    std::string name;
-    std::vector<NodePtr> args;
-    FuncCallNode(std::string n, std::vector<NodePtr> a): name(std::move(n)), args(std::move(a)) {}
+    static constexpr NodeKind KIND = NodeKind::FUNC_CALL;
+    Symbol name;
+    std::pmr::vector<NodePtr> args;
+    Slot slot;
+    FuncCallNode(Symbol n, std::pmr::vector<NodePtr> a): Node(KIND), name(n), args(std::move(a)) {}
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
         std::string typeStr = typeToString(type);
         if (!typeStr.empty()) {
-            std::cout << "FuncCall(" << name << " : " << typeStr << ")\n";
+            Trace::out() << "FuncCall(" << Symbols::name(name) << " : " << typeStr << ")\n";
         } else {
-            std::cout << "FuncCall(" << name << ")\n";
+            Trace::out() << "FuncCall(" << Symbols::name(name) << ")\n";
         }
         for (const auto &a : args) a->prettyPrint(indent+1);
     }
 };
 
 struct AssignNode : Node {
-    std::string name;
+    static constexpr NodeKind KIND = NodeKind::ASSIGN;
+    Symbol name;
     NodePtr expr;
-    AssignNode(std::string n, NodePtr e): name(std::move(n)), expr(std::move(e)) {}
+    Slot slot;
+    AssignNode(Symbol n, NodePtr e): Node(KIND), name(n), expr(std::move(e)) {}
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
-        std::cout << "Assign(" << name << ")\n";
+        Trace::out() << "Assign(" << Symbols::name(name) << ")\n";
         if (expr) expr->prettyPrint(indent+1);
     }
 };
 
 struct FuncDeclNode : Node {
-    std::string name;
-    std::vector<std::string> params;
+    static constexpr NodeKind KIND = NodeKind::FUNC_DECL;
+    Symbol name;
+    std::pmr::vector<Symbol> params;
     NodePtr body;
-    FuncDeclNode(std::string n, std::vector<std::string> p, NodePtr b)
-        : name(std::move(n)), params(std::move(p)), body(std::move(b)) {}
+    uint32_t frameSize = 0;
+    FuncDeclNode(Symbol n, std::pmr::vector<Symbol> p, NodePtr b)
+        : Node(KIND), name(n), params(std::move(p)), body(std::move(b)) {}
     void prettyPrint(int indent=0) const override {
         printIndent(indent);
         std::string typeStr = typeToString(type);
         if (!typeStr.empty()) {
-            std::cout << "FuncDecl(" << name << " : " << typeStr << ")\n";
+            Trace::out() << "FuncDecl(" << Symbols::name(name) << " : " << typeStr << ")\n";
         } else {
-            std::cout << "FuncDecl(" << name << ")\n";
+            Trace::out() << "FuncDecl(" << Symbols::name(name) << ")\n";
         }
         printIndent(indent+1);
-        std::cout << "Params:\n";
-        for (auto &p: params) { printIndent(indent+2); std::cout << p << "\n"; }
+        Trace::out() << "Params:\n";
+        for (auto &p: params) { printIndent(indent+2); Trace::out() << Symbols::name(p) << "\n"; }
         printIndent(indent+1);
-        std::cout << "Body:\n";
+        Trace::out() << "Body:\n";
         if (body) body->prettyPrint(indent+2);
     }
 };
 
+// Converte para o tipo concreto quando a tag bate; nullptr caso contrário.
+template<typename T>
+T* nodeAs(Node *node) {
+    return node && node->kind == T::KIND ? static_cast<T*>(node) : nullptr;
+}
+
+template<typename T>
+const T* nodeAs(const Node *node) {
+    return node && node->kind == T::KIND ? static_cast<const T*>(node) : nullptr;
+}
+
+template<typename From, typename To>
+using MatchConst = std::conditional_t<std::is_const_v<From>, const To, To>;
+
+// Junta lambdas num só visitor: visitNode(n, Overloaded{[](VarNode &) {...}, ...}).
+template<typename... Fs>
+struct Overloaded : Fs... {
+    using Fs::operator()...;
+};
+
+template<typename... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+// Chama visitor com o nó já no tipo concreto (um único switch na tag).
+// Todas as sobrecargas do visitor devem devolver o mesmo tipo.
+template<typename N, typename Visitor>
+decltype(auto) visitNode(N &node, Visitor &&visitor) {
+    switch (node.kind) {
+        case NodeKind::NUMBER: return visitor(static_cast<MatchConst<N, NumberNode>&>(node));
+        case NodeKind::VAR: return visitor(static_cast<MatchConst<N, VarNode>&>(node));
+        case NodeKind::BINARY_OP: return visitor(static_cast<MatchConst<N, BinaryOpNode>&>(node));
+        case NodeKind::UNARY_OP: return visitor(static_cast<MatchConst<N, UnaryOpNode>&>(node));
+        case NodeKind::FUNC_CALL: return visitor(static_cast<MatchConst<N, FuncCallNode>&>(node));
+        case NodeKind::ASSIGN: return visitor(static_cast<MatchConst<N, AssignNode>&>(node));
+        case NodeKind::FUNC_DECL: break;
+    }
+    return visitor(static_cast<MatchConst<N, FuncDeclNode>&>(node));
+}
+
+// Chama fn para cada filho não nulo, da esquerda para a direita.
+template<typename N, typename Fn>
+void forEachChild(N &node, Fn &&fn) {
+    switch (node.kind) {
+        case NodeKind::BINARY_OP: {
+            auto &n = static_cast<MatchConst<N, BinaryOpNode>&>(node);
+            if (n.left) fn(n.left);
+            if (n.right) fn(n.right);
+            break;
+        }
+        case NodeKind::UNARY_OP: {
+            auto &n = static_cast<MatchConst<N, UnaryOpNode>&>(node);
+            if (n.operand) fn(n.operand);
+            break;
+        }
+        case NodeKind::FUNC_CALL:
+            for (auto &arg : static_cast<MatchConst<N, FuncCallNode>&>(node).args) {
+                if (arg) fn(arg);
+            }
+            break;
+        case NodeKind::ASSIGN: {
+            auto &n = static_cast<MatchConst<N, AssignNode>&>(node);
+            if (n.expr) fn(n.expr);
+            break;
+        }
+        case NodeKind::FUNC_DECL: {
+            auto &n = static_cast<MatchConst<N, FuncDeclNode>&>(node);
+            if (n.body) fn(n.body);
+            break;
+        }
+        case NodeKind::NUMBER: case NodeKind::VAR:
+            break;
+    }
+}
+
 #endif
\ No newline at end of file
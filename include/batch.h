@@ -0,0 +1,70 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Kernels vetoriais só existem em x86-64 com GCC/Clang; nos demais alvos
+// (ou com -DMC_NO_SIMD) a avaliação em lote usa apenas o kernel escalar.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(MC_NO_SIMD)
+#define MC_SIMD_AVAILABLE 1
+#else
+#define MC_SIMD_AVAILABLE 0
+#endif
+
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+const char* simdLevelName(SimdLevel level);
+SimdLevel detectSimdLevel();
+
+// Uma operação aplicada a n linhas consecutivas: dst[i] = a[i] op b[i].
+using BatchKernel = void (*)(double *dst, const double *a, const double *b, size_t n);
+
+struct BatchKernels {
+    BatchKernel add;
+    BatchKernel sub;
+    BatchKernel mul;
+    BatchKernel div;
+    BatchKernel pow;
+    BatchKernel neg;
+};
+
+// Avalia uma função compilada sobre colunas de argumentos (layout SoA: uma
+// coluna contígua por parâmetro). As linhas são processadas em blocos de
+// TILE; cada registrador do frame vira um vetor de TILE valores e cada
+// instrução do bytecode roda como um kernel sobre o bloco inteiro.
+class BatchEvaluator {
+private:
+    const Program &program;
+    std::vector<double> constTiles;
+    std::vector<double> globalTiles;
+    std::vector<double> zeroTile;
+    std::vector<double> stack;
+    std::vector<uint32_t> stackNeeds;
+    BatchKernels kernels;
+    SimdLevel level;
+
+    uint32_t computeStackNeed(uint32_t index, std::vector<uint8_t> &state);
+    const double* operandTile(uint32_t operand, double *frame) const;
+    const double* runTile(const FunctionCode &fn, double *frame, size_t n);
+
+public:
+    static constexpr size_t TILE = 256;
+
+    BatchEvaluator(const Program &program, const std::vector<double> &globals);
+    void setSimdLevel(SimdLevel level);
+    SimdLevel getSimdLevel() const { return level; }
+
+    static uint32_t functionIndex(const Program &program, const std::string &name);
+    void evaluate(uint32_t function, const std::vector<const double*> &columns,
+                  size_t rows, double *out);
+};
+
+#endif
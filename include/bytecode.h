@@ -0,0 +1,82 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include "symbols.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class OpCode : uint8_t {
+    MOV,
+    ADD, SUB, MUL, DIV, POW,
+    NEG,
+    ARG,
+    CALL,
+    RET,
+    PRINT
+};
+
+// Operandos são codificados em 32 bits: os 2 bits altos indicam onde o valor
+// mora (registrador do frame, variável global ou constante) e o resto é o índice.
+enum class OperandKind : uint32_t {
+    REG = 0,
+    GLOBAL = 1,
+    CONST = 2
+};
+
+constexpr uint32_t OPERAND_INDEX_MASK = 0x3FFFFFFFu;
+constexpr uint32_t NO_OPERAND = 0xFFFFFFFFu;
+
+inline uint32_t makeOperand(OperandKind kind, uint32_t index) {
+    return (static_cast<uint32_t>(kind) << 30) | (index & OPERAND_INDEX_MASK);
+}
+
+inline OperandKind operandKind(uint32_t operand) {
+    return static_cast<OperandKind>(operand >> 30);
+}
+
+inline uint32_t operandIndex(uint32_t operand) {
+    return operand & OPERAND_INDEX_MASK;
+}
+
+// MOV:  dst = a
+// ADD..POW: dst = a op b
+// NEG:  dst = -a
+// ARG:  argumento dst da próxima chamada = a (escrito direto no frame do chamado)
+// CALL: dst = call functions[a] com b argumentos
+// RET:  return a
+// PRINT: mostra o valor de a (expressão usada como comando)
+struct Instruction {
+    OpCode op;
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
+};
+
+struct FunctionCode {
+    Symbol symbol = Symbols::NONE;
+    std::string name;
+    std::vector<std::string> params;
+    uint32_t numRegs = 0;
+    std::vector<Instruction> code;
+};
+
+struct Program {
+    std::vector<double> constants;
+    std::vector<std::string> globals;
+    std::vector<FunctionCode> functions;
+    FunctionCode main;
+};
+
+const char* opCodeSymbol(OpCode op);
+std::string formatNumber(double value);
+std::string operandName(const Program &program, const FunctionCode &fn, uint32_t operand);
+std::string disassemble(const Program &program, const FunctionCode &fn, const Instruction &ins);
+std::vector<std::string> disassembleProgram(const Program &program);
+
+// Por função: 1 se o corpo lê alguma global, direta ou indiretamente (pelas
+// funções que chama). O resultado de uma função assim muda quando a global
+// é reatribuída, mesmo com os mesmos argumentos.
+std::vector<char> functionsReadingGlobals(const Program &program);
+
+#endif
@@ -2,24 +2,64 @@
 #define CODEGEN_H
 
 #include "ast.h"
+#include "flat_ast.h"
+#include "bytecode.h"
+#include "ir_optimizer.h"
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <iostream>
 
 class CodeGenerator {
 private:
-    std::vector<std::string> codeLines;
-    int tempCounter;
-    
-    std::string newTemp();
-    std::string processNode(const Node* node);
+    Program program;
+    FunctionCode* current;
+    bool irOptimization;
+    IrStats irStats;
+    size_t threads;
+
+    std::unordered_map<Symbol, uint32_t> functionIndex;
+    std::unordered_map<uint64_t, uint32_t> constantIndex;
+
+    // Geração paralela: um worker lê os índices de função de `shared` e
+    // numera as próprias constantes; a junção as renumera no Program final.
+    const CodeGenerator *shared;
+
+    uint32_t slotOperand(const Slot &slot, Symbol name = Symbols::NONE);
+    uint32_t constant(double value);
+    void emit(const Instruction &ins);
+    uint32_t processNode(const Node* node);
+    uint32_t calleeIndex(Symbol name) const;
     void processFunctionDeclaration(FuncDeclNode* funcDecl);
-    
+    void processFunctionDeclaration(FuncDeclNode* funcDecl, FunctionCode &target);
+    void generateFunctionsParallel(const std::vector<FuncDeclNode*> &decls);
+    void processStatement(const Node* node);
+    uint32_t processFlatNode(const FlatAst &ast, uint32_t node, const std::vector<uint32_t> &operands);
+    void optimizeProgram();
+
 public:
+    // Com pelo menos PARALLEL_MIN_FUNCTIONS declarações, os corpos das
+    // funções são gerados em paralelo; o Program é idêntico ao serial.
+    static constexpr size_t PARALLEL_MIN_FUNCTIONS = 256;
+
     CodeGenerator();
+    // 0 usa os núcleos disponíveis; 1 gera tudo em série.
+    void setThreads(size_t count) { threads = count; }
     void generateCode(const std::vector<NodePtr> &ast);
+    // Mesmo bytecode a partir da AST plana, numa passada linear por comando.
+    void generateCode(const FlatAst &ast);
+    // Sessão incremental: acrescenta ao programa atual em vez de recomeçar.
+    // Uma função mantém o índice da primeira declaração quando é redefinida;
+    // um comando vira um trecho de main próprio, devolvido para ser executado.
+    // Nenhum dos dois passa pelo otimizador de IR.
+    uint32_t generateFunction(FuncDeclNode* funcDecl);
+    FunctionCode generateStatement(const Node* node);
+    void setIrOptimization(bool enabled) { irOptimization = enabled; }
     void printCode() const;
-    const std::vector<std::string>& getCodeLines() const { return codeLines; }
+    const IrStats& getIrStats() const { return irStats; }
+    // A listagem só é montada quando pedida; em modo silencioso não custa nada.
+    std::vector<std::string> getCodeLines() const { return disassembleProgram(program); }
+    const Program& getProgram() const { return program; }
 };
 
-#endif
\ No newline at end of file
+#endif
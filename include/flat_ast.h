@@ -0,0 +1,73 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class FlatKind : uint8_t {
+    NUMBER,
+    VAR,
+    BINARY,
+    UNARY,
+    CALL,
+    ASSIGN,
+    FUNC_DECL
+};
+
+// Um comando de topo ocupa a faixa contígua [first, last] de nós.
+// Expressões e atribuições são gravadas em pós-ordem (filhos antes do pai,
+// a raiz é `last`); a declaração de função grava o próprio nó antes do corpo
+// (a raiz é `first`), então uma passada linear já sabe em que função está.
+struct FlatStatement {
+    uint32_t first;
+    uint32_t last;
+};
+
+// Alternativa orientada a dados à árvore de Node: cada campo é um vetor
+// contíguo indexado pelo número do nó e os filhos são índices de 32 bits.
+// Uso de `a` e `b` por tipo de nó (nomes e parâmetros são Symbols):
+//   NUMBER     a = índice em numbers (literal já convertido)
+//   VAR        a = nome
+//   BINARY     a = esquerda, b = direita
+//   UNARY      a = operando
+//   CALL       a = nome, b = posição em lists: [n, arg1..argn]
+//   ASSIGN     a = nome, b = expressão
+//   FUNC_DECL  a = nome, b = posição em lists: [n, param1..paramn, corpo]
+// Em FUNC_DECL, slotIndices guarda o tamanho do frame.
+struct FlatAst {
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    std::vector<FlatKind> kinds;
+    std::vector<Operator> ops;
+    std::vector<Type> types;
+    std::vector<uint32_t> a;
+    std::vector<uint32_t> b;
+    std::vector<SlotKind> slotKinds;
+    std::vector<uint32_t> slotIndices;
+
+    std::vector<double> numbers;
+    std::vector<uint32_t> lists;
+    std::vector<FlatStatement> statements;
+
+    uint32_t addNode(FlatKind kind, Operator op, uint32_t a, uint32_t b, Type type = Type::UNKNOWN);
+    uint32_t addNumber(std::string_view text);
+
+    size_t nodeCount() const { return kinds.size(); }
+    Slot slot(uint32_t node) const { return Slot{slotKinds[node], slotIndices[node]}; }
+    void setSlot(uint32_t node, const Slot &slot);
+    uint32_t statementRoot(const FlatStatement &st) const {
+        return kinds[st.first] == FlatKind::FUNC_DECL ? st.first : st.last;
+    }
+
+    // Bytes ocupados pelos vetores (capacidade).
+    size_t bytesUsed() const;
+
+    // Mesmo formato de Node::prettyPrint.
+    void prettyPrint() const;
+    void prettyPrint(uint32_t node, int indent) const;
+};
+
+#endif
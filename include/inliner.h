@@ -0,0 +1,43 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "ast.h"
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Substitui chamadas a funções pequenas pelo corpo da função, com os
+// parâmetros trocados pelos argumentos. Funções em ciclos de chamada (como o
+// par mutuamente recursivo a/b) nunca são expandidas, nem corpos que leem uma
+// global ainda não atribuída no comando onde a chamada está. Roda depois da
+// análise semântica; como o corpo copiado vem com slots do frame da função
+// chamada, a análise precisa ser refeita antes da geração de código.
+class Inliner {
+private:
+    Arena &arena;
+    size_t budget;
+    size_t inlinedCalls;
+    std::unordered_map<Symbol, FuncDeclNode*> functions;
+    std::unordered_map<Symbol, size_t> functionPositions;  // comando da declaração
+    std::unordered_map<Symbol, size_t> globalPositions;    // comando da primeira atribuição
+    std::unordered_set<Symbol> recursive;
+    std::unordered_set<Symbol> processed;
+
+    void findRecursive();
+    void processFunction(FuncDeclNode *decl);
+    NodePtr cloneExpr(const Node *node,
+                      const std::unordered_map<Symbol, const Node*> &args);
+    NodePtr inlineCalls(NodePtr node, const FuncDeclNode *context, size_t position);
+    NodePtr expand(ArenaPtr<FuncCallNode> call, const FuncDeclNode *callee,
+                   const FuncDeclNode *context, size_t position);
+
+public:
+    static constexpr size_t DEFAULT_BUDGET = 16;
+
+    explicit Inliner(Arena &arena, size_t budget = DEFAULT_BUDGET);
+    void run(std::vector<NodePtr> &ast);
+    size_t getInlinedCalls() const { return inlinedCalls; }
+};
+
+#endif
@@ -1,38 +1,151 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "bytecode.h"
+#include "jit.h"
+#include "memo_cache.h"
+#include "schedule.h"
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <iostream>
-#include <utility>
+#include <memory>
+#include <cstddef>
 
-struct FunctionIR {
-    std::vector<std::string> params;  
-    std::vector<std::string> body;    
+// Despacho por computed goto (labels-as-values do GCC/Clang). Compile com
+// -DMC_NO_COMPUTED_GOTO para forçar o laço com switch portátil.
+#if defined(__GNUC__) && !defined(MC_NO_COMPUTED_GOTO)
+#define MC_COMPUTED_GOTO 1
+#else
+#define MC_COMPUTED_GOTO 0
+#endif
+
+// COUNTED é o laço com switch contando instruções e chamadas (--stats).
+enum class DispatchMode {
+    SWITCH,
+    THREADED,
+    COUNTED
+};
+
+// Forma executável do bytecode: além dos opcodes do Program, inclui
+// superinstruções (op + return, ARG... + CALL) e, no modo threaded, o
+// endereço do handler de cada instrução.
+enum class ExecOp : uint8_t {
+    MOV,
+    ADD, SUB, MUL, DIV, POW,
+    RET_ADD, RET_SUB, RET_MUL, RET_DIV, RET_POW,
+    NEG,
+    ARG,
+    CALL,
+    CALLV,
+    RET,
+    PRINT,
+    END,
+    COUNT
+};
+
+struct ExecInstr {
+    const void *handler;
+    ExecOp op;
+    uint32_t dst;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+};
+
+struct ExecFunction {
+    uint32_t numRegs = 0;
+    uint32_t frameNeed = 0;
+    NativeFunction native = nullptr;
+    MemoCache *memo = nullptr;
+    std::vector<ExecInstr> code;
+    std::vector<uint32_t> argOperands;
+};
+
+// Instruções despachadas e chamadas feitas pelo interpretador. Só são
+// contadas no modo COUNTED e no laço com trace; funções nativas do JIT
+// contam como uma chamada, sem as instruções.
+struct ExecCounters {
+    uint64_t instructions = 0;
+    uint64_t calls = 0;
+};
+
+// Estado de quem executa: o limite da pilha em uso e a profundidade de
+// chamadas. O programa principal usa a pilha do interpretador; na execução
+// paralela (schedule.h) cada worker tem a sua, e os valores de PRINT vão
+// para `printed`, para serem mostrados na ordem do programa.
+struct CallStack {
+    double *end = nullptr;
+    uint32_t depth = 0;
+    std::vector<double> *printed = nullptr;
+    ExecCounters counters;
 };
 
 class Interpreter {
 private:
+    Program program;
+    std::vector<double> globals;
 
-    std::unordered_map<std::string, double> variables;
-    std::unordered_map<std::string, FunctionIR> functions;
+    std::vector<ExecFunction> exec;
+    ExecFunction execMain;
+    DispatchMode dispatch;
+    bool trace;
+    const void *const *threadedHandlers;
+    std::unique_ptr<JitCompiler> jit;
+    std::vector<std::unique_ptr<MemoCache>> memos;
 
-    std::vector<std::string> mainLines;
-    std::vector<std::unordered_map<std::string, double>> callStack;
+    // Pilha de valores contígua e pré-alocada: cada chamada ocupa os
+    // numRegs slots logo acima do frame de quem chamou.
+    std::unique_ptr<double[]> stack;
+    CallStack mainStack;
+    uint32_t reservedArgs;
 
-    double getValue(const std::string& name);
-    void setValue(const std::string& name, double value);
-    void executeInstruction(const std::string& line);
+    // Execução paralela dos comandos de topo: o grafo e o código de cada unidade.
+    StatementGraph schedule;
+    std::vector<ExecFunction> unitCode;
+    size_t scheduleThreads;
 
-    std::pair<bool, double> executeLines(const std::vector<std::string>& lines);
+    void decode(const FunctionCode &fn, ExecFunction &out) const;
+    void bindHandlers();
+    void bindHandlers(ExecFunction &fn);
+    void reserveArgs(const FunctionCode &fn);
 
-    double callFunction(const std::string& name, const std::vector<double>& args);
+    double runTraced(const FunctionCode &fn, double *frame);
+    template<bool Counted>
+    double runSwitch(const ExecFunction &fn, double *frame, CallStack &cs);
+    double runThreaded(const ExecFunction *fn, double *frame, CallStack &cs);
+    double run(const ExecFunction &fn, double *frame, CallStack &cs);
+    double callFunction(uint32_t index, uint32_t argc, double *frame);
+    double callMemoized(const ExecFunction &target, double *frame, CallStack &cs);
+    const ExecFunction& enterCall(uint32_t index, double *frame, CallStack &cs);
+    void checkFrame(const std::string &name, uint32_t numRegs, double *frame, const CallStack &cs) const;
+    void runParallel();
 
 public:
-    Interpreter(const std::vector<std::string>& lines);
+    static constexpr size_t DEFAULT_STACK_SLOTS = 1 << 18;
+    static constexpr uint32_t MAX_CALL_DEPTH = 10000;
+
+    Interpreter(const Program &program, size_t stackSlots = DEFAULT_STACK_SLOTS);
+    void setDispatchMode(DispatchMode mode);
+    DispatchMode getDispatchMode() const { return dispatch; }
+    void setTrace(bool enabled) { trace = enabled; }
+    size_t enableJit();
+    void enableMemo(uint32_t capacity = MemoCache::DEFAULT_CAPACITY);
+    void printMemoStats() const;
+    // Passa a executar o programa principal pelas unidades do grafo, as
+    // independentes em paralelo (threads = 0 usa os núcleos disponíveis).
+    // Fica de fora com trace por instrução ou memoização.
+    void setSchedule(StatementGraph graph, size_t threads);
+    void runProgram();
     void execute();
     void printVariables() const;
+
+    // Sessão incremental (session.h): o Program cresce aos poucos e só o que
+    // mudou é decodificado de novo. Não combina com JIT nem memoização.
+    void syncData(const Program &source);
+    void setFunction(uint32_t index, const FunctionCode &fn);
+    void runStatement(const FunctionCode &code);
+    const std::vector<double>& getGlobals() const { return globals; }
+    const ExecCounters& getCounters() const { return mainStack.counters; }
 };
 
 #endif
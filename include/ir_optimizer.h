@@ -0,0 +1,35 @@
+#ifndef IR_OPTIMIZER_H
+#define IR_OPTIMIZER_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <vector>
+
+struct IrStats {
+    size_t redundant = 0;
+    size_t dead = 0;
+    size_t registersBefore = 0;
+    size_t registersAfter = 0;
+};
+
+// Otimizações sobre o bytecode já gerado. O código de cada função (e do
+// programa principal) é uma sequência linear e a linguagem não tem efeitos
+// colaterais, então todas as análises são locais a essa sequência.
+class IrOptimizer {
+private:
+    IrStats stats;
+    // Uma chamada só mantém globais vivas se o corpo chamado (direta ou
+    // indiretamente) lê alguma delas.
+    std::vector<char> readsGlobals;
+
+    void valueNumbering(FunctionCode &fn);
+    void eliminateDeadCode(FunctionCode &fn, size_t globalCount, bool topLevel);
+    void allocateRegisters(FunctionCode &fn);
+
+public:
+    IrOptimizer();
+    void optimize(Program &program);
+    const IrStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__)) && !defined(MC_NO_JIT)
+#define MC_JIT_AVAILABLE 1
+#else
+#define MC_JIT_AVAILABLE 0
+#endif
+
+// Funções compiladas usam o mesmo layout de frame do interpretador: recebem
+// em rdi o ponteiro para o frame (parâmetros nos primeiros slots) e devolvem
+// o resultado em xmm0.
+using NativeFunction = double (*)(double *frame);
+
+class JitCompiler {
+private:
+    void *memory;
+    size_t memorySize;
+    std::vector<NativeFunction> entries;
+    std::vector<uint32_t> stackNeeds;
+
+    std::vector<bool> selectFunctions(const Program &program) const;
+
+public:
+    JitCompiler();
+    ~JitCompiler();
+    JitCompiler(const JitCompiler &) = delete;
+    JitCompiler& operator=(const JitCompiler &) = delete;
+
+    size_t compile(const Program &program, double *globals);
+    NativeFunction entry(uint32_t index) const;
+    uint32_t stackNeed(uint32_t index) const;
+    size_t codeSize() const { return memorySize; }
+};
+
+#endif
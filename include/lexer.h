@@ -2,22 +2,44 @@
 #define LEXER_H
 
 #include "token.h"
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
-class Lexer {
+struct SourceLocation {
+    int line;
+    int column;
+};
+
+// Início de cada linha do código, montado só na primeira consulta: o lexer
+// não conta linhas e colunas, e quem imprime tokens ou erros pergunta aqui.
+class LineIndex {
 private:
-    std::string source;
-    size_t pos;
-    int line, column;
+    std::string_view source;
+    mutable std::vector<uint32_t> starts;
+
+public:
+    explicit LineIndex(std::string_view src) : source(src) {}
+    SourceLocation locate(const char *at) const;
+    SourceLocation locate(const Token &token) const { return locate(token.value.data()); }
+};
 
-    char peek() const;
-    char get();
-    void skipWhitespace();
+// Lê direto da memória de quem chamou (string, arquivo mapeado...), sem
+// copiar o código: o valor de cada token é uma view do texto, que precisa
+// continuar vivo enquanto os tokens forem usados. O parser puxa um token por
+// vez com next(); tokenize() junta todos num vetor para listagem.
+class Lexer {
+private:
+    std::string_view source;
+    const char *cursor;
+    LineIndex lines;
 
 public:
-    Lexer(const std::string &src);
+    explicit Lexer(std::string_view src);
+    // Depois do fim devolve sempre END_OF_FILE.
+    Token next();
     std::vector<Token> tokenize();
+    const LineIndex& getLines() const { return lines; }
 };
 
 #endif
@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MC_HAS_MMAP 1
+#else
+#define MC_HAS_MMAP 0
+#endif
+
+// Arquivo somente leitura mapeado em memória. Sem mmap (Windows), o conteúdo
+// é lido inteiro para um buffer e a interface é a mesma.
+class MappedFile {
+private:
+    std::string path;
+    const char *base;
+    size_t length;
+    std::vector<char> fallback;
+
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(base, length); }
+    const std::string& getPath() const { return path; }
+
+    // Avisa o sistema que a faixa já foi consumida e as páginas podem sair
+    // da memória; mantém o uso de memória limitado em arquivos grandes.
+    void release(size_t offset, size_t bytes) const;
+};
+
+#endif
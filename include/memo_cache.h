@@ -0,0 +1,53 @@
+#ifndef MEMO_CACHE_H
+#define MEMO_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MemoStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+// Cache de resultados de uma função pura, indexado pelos bits dos argumentos
+// (então 0 e -0, ou NaNs diferentes, são chaves distintas). Guarda no máximo
+// `capacity` entradas; quando cheio, a substituição segue o algoritmo do
+// relógio (segunda chance).
+class MemoCache {
+private:
+    uint32_t argc;
+    uint32_t capacity;
+    uint32_t count;
+    uint32_t hand;
+
+    std::vector<uint64_t> keys;        // argc palavras por entrada
+    std::vector<uint64_t> hashes;
+    std::vector<double> values;
+    std::vector<uint8_t> referenced;
+
+    // Índice com sondagem linear: guarda entrada + 1 (0 = posição vazia).
+    std::vector<uint32_t> table;
+    uint32_t mask;
+
+    MemoStats stats;
+
+    uint64_t hashArgs(const double *args) const;
+    bool sameKey(uint32_t entry, const double *args) const;
+    uint32_t findSlot(uint32_t entry) const;
+    void removeFromTable(uint32_t entry);
+    uint32_t evict();
+
+public:
+    static constexpr uint32_t DEFAULT_CAPACITY = 1024;
+    static constexpr uint32_t MAX_CAPACITY = 1u << 24;  // capacidades maiores são reduzidas a esta
+
+    MemoCache(uint32_t argc, uint32_t capacity = DEFAULT_CAPACITY);
+    bool lookup(const double *args, double &value);
+    void insert(const double *args, double value);
+    size_t size() const { return count; }
+    const MemoStats& getStats() const { return stats; }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ast.h"
+#include <cstddef>
+#include <vector>
+
+// Passo entre a análise semântica e a geração de código: dobra subárvores
+// constantes e aplica identidades algébricas. Depende dos tipos e slots já
+// calculados pelo SemanticAnalyzer.
+class Optimizer {
+private:
+    Arena &arena;
+    size_t removedNodes;
+
+    NodePtr fold(NodePtr node);
+    NodePtr foldBinary(ArenaPtr<BinaryOpNode> node);
+    NodePtr foldUnary(ArenaPtr<UnaryOpNode> node);
+
+    NodePtr cloneLeaf(const NodePtr &node);
+    NodePtr makeNumber(double value, Type type);
+
+    static size_t countNodes(const Node *node);
+
+public:
+    explicit Optimizer(Arena &arena);
+    void optimize(std::vector<NodePtr> &ast);
+    size_t getRemovedNodes() const { return removedNodes; }
+};
+
+#endif
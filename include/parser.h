@@ -1,37 +1,52 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include "token.h"
+#include "lexer.h"
 #include "ast.h"
+#include "flat_ast.h"
 #include <vector>
 #include <memory>
 
+// Puxa os tokens do lexer sob demanda: só a janela de LOOKAHEAD tokens
+// fica guardada, nunca o código inteiro tokenizado.
 class Parser {
 private:
-    const std::vector<Token> tokens;
-    size_t idx;
+    static constexpr size_t LOOKAHEAD = 2;
+
+    Lexer &lexer;
+    Token window[LOOKAHEAD];
+    size_t head;
+    Arena &arena;
 
     const Token& current() const;
+    // Token `n` posições depois do atual (n < LOOKAHEAD).
+    const Token& peek(size_t n) const;
     void advance();
     bool accept(TokenType t);
-    bool acceptValue(TokenType t, const std::string &val);
+    bool isOperator(Operator op) const;
     void expect(TokenType t, const std::string &msg);
 
-    NodePtr parseProgram();
-    NodePtr parseDeclaration();
-    NodePtr parseAssignment();
-    NodePtr parseExpression();
-    NodePtr parseTerm();
-    NodePtr parsePower();
-    NodePtr parseUnary();
-    NodePtr parseFactor();
-    std::vector<std::string> parseParameters();
-    std::vector<NodePtr> parseArguments();
+    // Uma gramática só para as duas representações: `Builder` decide o que
+    // cada regra produz (nós da árvore ou índices da AST plana). Definidas
+    // e instanciadas em parser.cpp.
+    template<typename Builder> typename Builder::Ref parseProgram(Builder &build);
+    template<typename Builder> typename Builder::Ref parseDeclaration(Builder &build);
+    template<typename Builder> typename Builder::Ref parseAssignment(Builder &build);
+    template<typename Builder> typename Builder::Ref parseExpression(Builder &build);
+    template<typename Builder> typename Builder::Ref parseTerm(Builder &build);
+    template<typename Builder> typename Builder::Ref parsePower(Builder &build);
+    template<typename Builder> typename Builder::Ref parseUnary(Builder &build);
+    template<typename Builder> typename Builder::Ref parseFactor(Builder &build);
+    template<typename Builder> typename Builder::Params parseParameters(Builder &build);
+    template<typename Builder> typename Builder::Args parseArguments(Builder &build);
 
 public:
-    Parser(const std::vector<Token>& toks);
+    // Nós e nomes são alocados em `arena`, que precisa durar mais que a AST.
+    Parser(Lexer &lexer, Arena &arena);
     NodePtr parse(); 
     std::vector<NodePtr> parseAll(); 
+    // Mesma gramática, acrescentando os comandos direto em `out`.
+    void parseAllFlat(FlatAst &out);
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Trecho contíguo do programa principal executado como uma tarefa: um ou
+// mais comandos de topo. Registradores nunca passam de uma unidade para
+// outra, então cada unidade pode rodar num frame próprio.
+struct MainUnit {
+    uint32_t begin = 0;              // faixa [begin, end) de StatementGraph::code
+    uint32_t end = 0;
+    bool calls = false;              // tem chamada de função
+    std::vector<uint32_t> deps;      // unidades anteriores que precisam terminar antes
+};
+
+// Grafo de dependências entre os comandos de topo. Uma unidade depende de
+// outra anterior quando lê uma global que ela escreve, escreve uma global
+// que ela lê ou as duas escrevem a mesma global; as globais lidas por uma
+// chamada incluem as que a função (e quem ela chama) consulta. Sequências de
+// comandos sem chamadas viram uma unidade só, que não compensa uma tarefa.
+struct StatementGraph {
+    // Código do programa principal em que a leitura de um registrador vindo
+    // de outro comando (x = t0 e depois y = t0 + 1) passa a ler a global que
+    // guarda o mesmo valor (y = x + 1), para que os comandos fiquem separáveis.
+    std::vector<Instruction> code;
+    std::vector<MainUnit> units;
+    size_t edges = 0;
+
+    // Só compensa executar em paralelo com duas ou mais unidades com chamadas.
+    bool worthParallel() const;
+};
+
+StatementGraph buildStatementGraph(const Program &program);
+
+#endif
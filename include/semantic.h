@@ -2,6 +2,7 @@
 #define SEMANTIC_H
 
 #include "ast.h"
+#include "flat_ast.h"
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -16,6 +17,7 @@ public:
 struct VariableInfo {
     Type type;
     bool initialized;
+    Slot slot;
 };
 
 struct FunctionInfo {
@@ -24,35 +26,97 @@ struct FunctionInfo {
     Type returnType;
 };
 
+// Estado de uma global a partir do comando `statement` (declaração ou
+// nova atribuição que muda o tipo).
+struct GlobalVersion {
+    uint32_t statement;
+    VariableInfo info;
+};
+
 class SemanticAnalyzer {
 private:
-    std::vector<std::unordered_map<std::string, VariableInfo>> variableScopes;
-    std::unordered_map<std::string, FunctionInfo> functions;
+    std::vector<std::unordered_map<Symbol, VariableInfo>> variableScopes;
+    std::unordered_map<Symbol, FunctionInfo> functions;
+
+    uint32_t globalCount;
+    uint32_t frameBase;
+    uint32_t tempCount;
+    uint32_t mainFrameSize;
+    size_t threads;
+    mutable size_t lookups;      // buscas de nomes nos escopos (--stats)
+
+    // Análise paralela dos corpos de função: o passo serial grava cada
+    // atribuição de topo numa linha do tempo, e cada worker enxerga as globais
+    // como estavam no comando `position` da sua declaração. As funções
+    // registradas são lidas de `shared` (o analisador principal).
+    const SemanticAnalyzer *shared;
+    uint32_t position;
+    bool recording;
+    std::unordered_map<Symbol, std::vector<GlobalVersion>> timeline;
+
+    // AST plana: início da subárvore de cada nó do comando e as chamadas na
+    // ordem em que são conferidas (reaproveitados entre comandos).
+    std::vector<uint32_t> flatStarts;
+    std::vector<uint32_t> flatCalls;
+
+    explicit SemanticAnalyzer(const SemanticAnalyzer *shared);
 
     void pushScope();
     void popScope();
 
-    void declareVariable(const std::string &name, Type type = Type::UNKNOWN);
-    bool isVariableDeclared(const std::string &name) const;
-    Type getVariableType(const std::string &name) const;
+    Slot declareVariable(Symbol name, Type type = Type::UNKNOWN);
+    Slot declareParameter(Symbol name, uint32_t index);
+    const VariableInfo* findVariable(Symbol name) const;
+    bool isVariableDeclared(Symbol name) const;
+    Type getVariableType(Symbol name) const;
+    Slot getVariableSlot(Symbol name) const;
+    Slot allocateTemp();
 
     void registerFunction(const FuncDeclNode *func);
-    bool isFunctionDeclared(const std::string &name) const;
-    FunctionInfo getFunctionInfo(const std::string &name) const;
+    bool isFunctionDeclared(Symbol name) const;
+    FunctionInfo getFunctionInfo(Symbol name) const;
+    const std::unordered_map<Symbol, FunctionInfo>& registry() const {
+        return shared ? shared->functions : functions;
+    }
+    void analyzeParallel(std::vector<NodePtr> &ast);
 
     Type analyzeNode(NodePtr &node);
     Type analyzeAssign(AssignNode *n);
     Type analyzeFuncDecl(FuncDeclNode *n);
     Type analyzeBinary(BinaryOpNode *n);
+    Type analyzeUnary(UnaryOpNode *n);
     Type analyzeVar(VarNode *n);
     Type analyzeFuncCall(FuncCallNode *n);
     Type analyzeNumber(const NumberNode *n);
 
-    Type checkBinaryOpTypes(const std::string &op, Type left, Type right);
+    void registerFunction(const FlatAst &ast, uint32_t decl);
+    void analyzeFlatDecl(FlatAst &ast, const FlatStatement &st);
+    void analyzeFlatRange(FlatAst &ast, uint32_t first, uint32_t last);
+    void analyzeFlatNode(FlatAst &ast, uint32_t node);
+    void checkFlatCall(const FlatAst &ast, uint32_t node);
+
+    Type checkBinaryOpTypes(Operator op, Type left, Type right);
 
 public:
+    // Com pelo menos PARALLEL_MIN_FUNCTIONS declarações, os corpos das
+    // funções são analisados em paralelo; o resultado (slots, tipos e o
+    // primeiro erro na ordem do código) é o mesmo da análise serial.
+    static constexpr size_t PARALLEL_MIN_FUNCTIONS = 256;
+
     SemanticAnalyzer();
+    // 0 usa os núcleos disponíveis; 1 analisa tudo em série.
+    void setThreads(size_t count) { threads = count; }
     void analyze(std::vector<NodePtr> &ast);
+    // Mesmas regras sobre a AST plana, em passadas lineares pelos nós de
+    // cada comando (que estão em pós-ordem).
+    void analyze(FlatAst &ast);
+    // Sessão incremental: analisa um comando sobre tudo o que já foi visto.
+    // Declarar de novo uma função substitui a anterior; se o comando tiver
+    // erro, o estado fica como estava.
+    void analyzeStatement(NodePtr &node);
+    uint32_t getGlobalCount() const { return globalCount; }
+    uint32_t getMainFrameSize() const { return mainFrameSize; }
+    size_t getLookups() const { return lookups; }
 };
 
 #endif
\ No newline at end of file
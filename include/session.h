@@ -0,0 +1,69 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "ast.h"
+#include "semantic.h"
+#include "codegen.h"
+#include "interpreter.h"
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Sessão persistente (--repl): cada linha é analisada, compilada e executada
+// sozinha sobre o estado deixado pelas anteriores. Um grafo de dependências
+// liga cada definição (função ou atribuição a global) ao que ela lê; quando
+// algo é redefinido, só a função nova é gerada de novo e só as atribuições
+// que dependem dela (direta ou indiretamente) são recalculadas. O custo de
+// uma edição não depende do tamanho da sessão.
+class Session {
+private:
+    // Funções e globais têm espaços de nomes separados: o bit mais baixo diz
+    // de qual dos dois é o símbolo.
+    using Key = uint64_t;
+    static Key functionKey(Symbol name) { return (static_cast<Key>(name) << 1) | 1; }
+    static Key globalKey(Symbol name) { return static_cast<Key>(name) << 1; }
+    static bool isFunction(Key key) { return (key & 1) != 0; }
+
+    struct Definition {
+        std::vector<Key> reads;                          // funções e globais usadas
+        std::vector<std::pair<Symbol, uint32_t>> calls;  // chamadas e nº de argumentos
+        uint64_t order = 0;                              // posição da última definição
+        uint32_t global = 0;                             // slot, nas atribuições
+        FunctionCode code;                               // trecho que recalcula a global
+    };
+
+    // Os nós das linhas ficam na arena até o fim da sessão, como na compilação.
+    Arena arena;
+    SemanticAnalyzer sem;
+    CodeGenerator codegen;
+    Interpreter interpreter;
+
+    std::unordered_map<Key, Definition> definitions;
+    std::unordered_map<Key, std::unordered_set<Key>> users;
+    uint64_t clock;
+    size_t recomputed;
+
+    void apply(NodePtr &node);
+    void checkCallers(const FuncDeclNode *decl) const;
+    void link(Key key, Definition &def, const Node *node);
+    void recompute(Key changed);
+    void run(const FunctionCode &code);
+    void report(const Definition &def, Symbol name, bool again) const;
+
+public:
+    Session();
+
+    // Processa uma linha (um ou mais comandos). Um erro descarta só o
+    // comando em que aconteceu; a sessão continua.
+    void submit(std::string_view line);
+
+    size_t definitionCount() const { return definitions.size(); }
+    // Atribuições recalculadas pela última linha por causa de dependências.
+    size_t lastRecomputed() const { return recomputed; }
+    const std::vector<double>& getGlobals() const { return interpreter.getGlobals(); }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Alocações no heap feitas pelo operator new (substituído em stats.cpp).
+// A contagem só acontece depois de enableAllocCounting; desligada, cada
+// alocação paga apenas a leitura de uma flag.
+struct AllocCounters {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+void enableAllocCounting();
+AllocCounters allocCounters();
+
+// Pico de memória residente do processo em bytes (0 onde não há getrusage).
+size_t peakMemory();
+
+// Relatório de --stats: tempo e alocações de cada fase, medidos entre
+// begin() e end() (medições com o mesmo nome se somam), e os totais do
+// programa. Desligado, não mede nada.
+class StatsReport {
+private:
+    struct Phase {
+        const char *name;
+        double seconds;
+        AllocCounters allocs;
+    };
+
+    bool enabled;
+    std::chrono::steady_clock::time_point started;
+    AllocCounters startedAllocs;
+    std::vector<Phase> phases;
+
+public:
+    size_t tokens = 0;
+    size_t nodes = 0;
+    size_t instructions = 0;
+    size_t scopeLookups = 0;
+    uint64_t dispatched = 0;
+    uint64_t calls = 0;
+
+    explicit StatsReport(bool enabled);
+    bool isEnabled() const { return enabled; }
+    void begin();
+    void end(const char *phase);
+    void print(std::ostream &out) const;
+};
+
+#endif
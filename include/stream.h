@@ -0,0 +1,55 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class StreamFormat {
+    CSV,
+    BINARY
+};
+
+// CSV: uma linha por chamada, valores separados por vírgula, ponto e vírgula
+// ou espaço (uma primeira linha não numérica é tratada como cabeçalho); a
+// saída tem um resultado por linha.
+// BINARY: doubles nativos organizados por coluna (todos os valores do
+// primeiro parâmetro, depois os do segundo...); a saída é a coluna de
+// resultados no mesmo formato.
+struct StreamOptions {
+    std::string input;
+    std::string output;
+    StreamFormat format = StreamFormat::CSV;
+    size_t threads = 0;                 // 0 = núcleos disponíveis
+    size_t chunkBytes = 1 << 20;        // tamanho aproximado de um bloco CSV
+    size_t chunkRows = 1 << 16;         // linhas por bloco binário
+    size_t window = 0;                  // blocos em andamento; 0 = 4 por thread
+};
+
+struct StreamStats {
+    size_t rows = 0;
+    size_t chunks = 0;
+    size_t threads = 0;
+    double seconds = 0.0;
+};
+
+// Avalia uma função sobre um arquivo grande mapeado em memória. O arquivo é
+// dividido em blocos avaliados em paralelo (BatchEvaluator por worker) e os
+// resultados são gravados na ordem da entrada. No máximo `window` blocos
+// ficam em memória ao mesmo tempo, então o consumo não depende do tamanho
+// do arquivo.
+class StreamEvaluator {
+private:
+    const Program &program;
+    std::vector<double> globals;
+    uint32_t function;
+    size_t arity;
+
+public:
+    StreamEvaluator(const Program &program, const std::vector<double> &globals, uint32_t function);
+    StreamStats run(const StreamOptions &options);
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Número denso de um identificador: 0, 1, 2... na ordem em que o lexer o
+// encontrou pela primeira vez.
+using Symbol = uint32_t;
+
+// Tabela única de identificadores do processo. Só o lexer chama intern();
+// daí em diante tokens, nós e tabelas das outras fases guardam o Symbol, e
+// comparar ou procurar um nome é comparar inteiros. O texto só é consultado
+// de volta com name() para imprimir e montar mensagens de erro.
+class Symbols {
+public:
+    static constexpr Symbol NONE = UINT32_MAX;
+
+    static Symbol intern(std::string_view text);
+    // NONE se o texto nunca apareceu no código.
+    static Symbol find(std::string_view text);
+    static std::string_view name(Symbol symbol);
+    static size_t count();
+};
+
+#endif
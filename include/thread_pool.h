@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de threads com roubo de trabalho: cada worker tem a própria fila,
+// consome do fim dela e, quando vazia, rouba do início da fila de outro.
+// Tarefas submetidas de dentro de um worker vão para a fila dele.
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> pending;
+    std::atomic<size_t> nextQueue;
+    bool stopping;
+
+    bool popLocal(size_t index, std::function<void()> &task);
+    bool steal(size_t index, std::function<void()> &task);
+    void workerLoop(size_t index);
+
+public:
+    static constexpr size_t NOT_A_WORKER = static_cast<size_t>(-1);
+
+    // threads = 0 usa o número de núcleos disponíveis
+    explicit ThreadPool(size_t threads = 0);
+    // Quantas threads um pool criado com `threads` teria.
+    static size_t resolveThreads(size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool& operator=(const ThreadPool &) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();
+    size_t size() const { return workers.size(); }
+
+    // Índice do worker deste pool que executa a thread atual, ou NOT_A_WORKER.
+    size_t currentWorker() const;
+};
+
+#endif
@@ -1,22 +1,49 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include "symbols.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     ID, NUM, FUNC,
     OP_ARIT, ATRIB,
     LPAREN, RPAREN, COMMA,
     END_OF_FILE, INVALID
 };
 
+// Operador já decodificado pelo lexer; NEG só aparece depois do otimizador.
+enum class Operator : uint8_t {
+    NONE,
+    ADD, SUB, MUL, DIV, POW,
+    NEG
+};
+
+// `value` aponta para o código-fonte; linha e coluna saem de LineIndex.
+// Os campos pequenos vêm antes da view para o token caber em 24 bytes.
 struct Token {
-    TokenType type;
-    std::string value;
-    int line;
-    int column;
+    TokenType type = TokenType::END_OF_FILE;
+    Operator op = Operator::NONE;     // OP_ARIT
+    Symbol symbol = Symbols::NONE;    // ID
+    std::string_view value;
+
+    Token() = default;
+    Token(TokenType t, std::string_view v, Symbol s = Symbols::NONE, Operator o = Operator::NONE)
+        : type(t), op(o), symbol(s), value(v) {}
 };
 
+inline const char* operatorSymbol(Operator op) {
+    switch (op) {
+        case Operator::ADD: return "+";
+        case Operator::SUB: case Operator::NEG: return "-";
+        case Operator::MUL: return "*";
+        case Operator::DIV: return "/";
+        case Operator::POW: return "^";
+        default: return "?";
+    }
+}
+
 inline std::string tokenTypeToString(TokenType t) {
     switch (t) {
         case TokenType::ID: return "ID";
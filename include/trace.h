@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// Níveis da linha de comando; cada um liga um conjunto de canais.
+enum class TraceLevel : uint8_t {
+    QUIET,      // só a saída do programa (resultados de expressões, lote)
+    SUMMARY,    // + resumo das fases e variáveis finais
+    CODE,       // + tokens, AST e código intermediário
+    FULL        // + cada instrução executada (padrão)
+};
+
+// Buffer de saída único: acumula em memória e só escreve no stdout quando
+// enche ou quando alguém pede flush, em vez de a cada linha.
+class TraceBuffer : public std::streambuf {
+private:
+    static constexpr size_t CAPACITY = 1 << 16;
+    std::FILE *file;
+    char buffer[CAPACITY];
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int sync() override;
+
+public:
+    explicit TraceBuffer(std::FILE *file);
+    ~TraceBuffer() override;
+};
+
+// Toda a saída do compilador passa por Trace::out(). Quem imprime confere
+// antes o canal com Trace::enabled, então canais desligados não formatam nada.
+class Trace {
+private:
+    static unsigned channels;
+
+public:
+    enum Channel : unsigned {
+        LEXER = 1 << 0,
+        PARSER = 1 << 1,
+        CODEGEN = 1 << 2,
+        EXEC = 1 << 3,
+        SUMMARY = 1 << 4,
+        ALL = (1 << 5) - 1
+    };
+
+    static bool enabled(Channel channel) { return (channels & channel) != 0; }
+    static unsigned getChannels() { return channels; }
+    static void setChannels(unsigned mask) { channels = mask & ALL; }
+    static void setLevel(TraceLevel level);
+
+    // Lista separada por vírgulas (lexer,parser,codegen,exec); devolve false
+    // se algum nome for desconhecido.
+    static bool parseChannels(const std::string &list, unsigned &mask);
+
+    static std::ostream& out();
+    static void flush();
+};
+
+#endif
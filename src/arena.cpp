@@ -0,0 +1,41 @@
+#include "../include/arena.h"
+#include <cstdint>
+#include <cstring>
+
+Arena::Arena() : cursor(nullptr), limit(nullptr), used(0), reserved(0) {}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    auto aligned = [&](char *p) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(p);
+        return p + ((alignment - address % alignment) % alignment);
+    };
+
+    // pedidos maiores que um bloco ganham um bloco só para eles, sem
+    // descartar o espaço que sobra no bloco atual
+    if (bytes + alignment > BLOCK_SIZE) {
+        blocks.emplace_back(new char[bytes + alignment]);
+        reserved += bytes + alignment;
+        used += bytes;
+        return aligned(blocks.back().get());
+    }
+
+    char *p = cursor ? aligned(cursor) : nullptr;
+    if (!p || p + bytes > limit) {
+        blocks.emplace_back(new char[BLOCK_SIZE]);
+        cursor = blocks.back().get();
+        limit = cursor + BLOCK_SIZE;
+        reserved += BLOCK_SIZE;
+        p = aligned(cursor);
+    }
+
+    used += static_cast<size_t>(p + bytes - cursor);
+    cursor = p + bytes;
+    return p;
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) return {};
+    char *p = static_cast<char *>(allocate(text.size(), 1));
+    std::memcpy(p, text.data(), text.size());
+    return std::string_view(p, text.size());
+}
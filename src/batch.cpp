@@ -0,0 +1,283 @@
+#include "../include/batch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if MC_SIMD_AVAILABLE
+#include <immintrin.h>
+#endif
+
+static constexpr double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
+static constexpr uint32_t RECURSIVE = std::numeric_limits<uint32_t>::max();
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR: return "escalar";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+    }
+    return "?";
+}
+
+SimdLevel detectSimdLevel() {
+#if MC_SIMD_AVAILABLE
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// Kernels escalares: também fazem a cauda (n % largura) dos vetoriais.
+static void scalarAdd(double *d, const double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] + b[i];
+}
+
+static void scalarSub(double *d, const double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] - b[i];
+}
+
+static void scalarMul(double *d, const double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = a[i] * b[i];
+}
+
+// Mesma semântica do interpretador: divisor zero produz NaN.
+static void scalarDiv(double *d, const double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = b[i] == 0.0 ? NOT_A_NUMBER : a[i] / b[i];
+}
+
+// Não há pow vetorial sem uma biblioteca de matemática SIMD; todos os níveis
+// usam std::pow elemento a elemento.
+static void scalarPow(double *d, const double *a, const double *b, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = std::pow(a[i], b[i]);
+}
+
+static void scalarNeg(double *d, const double *a, const double *, size_t n) {
+    for (size_t i = 0; i < n; ++i) d[i] = -a[i];
+}
+
+static const BatchKernels SCALAR_KERNELS = {
+    scalarAdd, scalarSub, scalarMul, scalarDiv, scalarPow, scalarNeg
+};
+
+#if MC_SIMD_AVAILABLE
+
+#define MC_AVX2 __attribute__((target("avx2")))
+#define MC_AVX512 __attribute__((target("avx512f")))
+
+#define AVX2_BINARY(name, intrinsic, scalar)                                   \
+    MC_AVX2 static void name(double *d, const double *a, const double *b, size_t n) { \
+        size_t i = 0;                                                          \
+        for (; i + 4 <= n; i += 4) {                                           \
+            _mm256_storeu_pd(d + i, intrinsic(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))); \
+        }                                                                      \
+        scalar(d + i, a + i, b + i, n - i);                                    \
+    }
+
+AVX2_BINARY(avx2Add, _mm256_add_pd, scalarAdd)
+AVX2_BINARY(avx2Sub, _mm256_sub_pd, scalarSub)
+AVX2_BINARY(avx2Mul, _mm256_mul_pd, scalarMul)
+
+MC_AVX2 static void avx2Div(double *d, const double *a, const double *b, size_t n) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d nan = _mm256_set1_pd(NOT_A_NUMBER);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vb = _mm256_loadu_pd(b + i);
+        __m256d q = _mm256_div_pd(_mm256_loadu_pd(a + i), vb);
+        __m256d isZero = _mm256_cmp_pd(vb, zero, _CMP_EQ_OQ);
+        _mm256_storeu_pd(d + i, _mm256_blendv_pd(q, nan, isZero));
+    }
+    scalarDiv(d + i, a + i, b + i, n - i);
+}
+
+MC_AVX2 static void avx2Neg(double *d, const double *a, const double *, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(d + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+    }
+    scalarNeg(d + i, a + i, nullptr, n - i);
+}
+
+#define AVX512_BINARY(name, intrinsic, scalar)                                 \
+    MC_AVX512 static void name(double *d, const double *a, const double *b, size_t n) { \
+        size_t i = 0;                                                          \
+        for (; i + 8 <= n; i += 8) {                                           \
+            _mm512_storeu_pd(d + i, intrinsic(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i))); \
+        }                                                                      \
+        scalar(d + i, a + i, b + i, n - i);                                    \
+    }
+
+AVX512_BINARY(avx512Add, _mm512_add_pd, scalarAdd)
+AVX512_BINARY(avx512Sub, _mm512_sub_pd, scalarSub)
+AVX512_BINARY(avx512Mul, _mm512_mul_pd, scalarMul)
+
+MC_AVX512 static void avx512Div(double *d, const double *a, const double *b, size_t n) {
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d nan = _mm512_set1_pd(NOT_A_NUMBER);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d vb = _mm512_loadu_pd(b + i);
+        __m512d q = _mm512_div_pd(_mm512_loadu_pd(a + i), vb);
+        __mmask8 isZero = _mm512_cmp_pd_mask(vb, zero, _CMP_EQ_OQ);
+        _mm512_storeu_pd(d + i, _mm512_mask_blend_pd(isZero, q, nan));
+    }
+    scalarDiv(d + i, a + i, b + i, n - i);
+}
+
+// xor de ponto flutuante em 512 bits exige AVX-512DQ; o xor inteiro é AVX-512F.
+MC_AVX512 static void avx512Neg(double *d, const double *a, const double *, size_t n) {
+    const __m512i sign = _mm512_set1_epi64(static_cast<long long>(0x8000000000000000ull));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i bits = _mm512_castpd_si512(_mm512_loadu_pd(a + i));
+        _mm512_storeu_pd(d + i, _mm512_castsi512_pd(_mm512_xor_si512(bits, sign)));
+    }
+    scalarNeg(d + i, a + i, nullptr, n - i);
+}
+
+static const BatchKernels AVX2_KERNELS = {
+    avx2Add, avx2Sub, avx2Mul, avx2Div, scalarPow, avx2Neg
+};
+
+static const BatchKernels AVX512_KERNELS = {
+    avx512Add, avx512Sub, avx512Mul, avx512Div, scalarPow, avx512Neg
+};
+
+#endif
+
+BatchEvaluator::BatchEvaluator(const Program &prog, const std::vector<double> &globals)
+    : program(prog), zeroTile(TILE, 0.0), kernels(SCALAR_KERNELS), level(SimdLevel::SCALAR) {
+    constTiles.resize(program.constants.size() * TILE);
+    for (size_t i = 0; i < program.constants.size(); ++i) {
+        std::fill_n(constTiles.begin() + i * TILE, TILE, program.constants[i]);
+    }
+    globalTiles.resize(globals.size() * TILE);
+    for (size_t i = 0; i < globals.size(); ++i) {
+        std::fill_n(globalTiles.begin() + i * TILE, TILE, globals[i]);
+    }
+
+    std::vector<uint8_t> state(program.functions.size(), 0);
+    stackNeeds.assign(program.functions.size(), 0);
+    for (uint32_t i = 0; i < program.functions.size(); ++i) computeStackNeed(i, state);
+
+    setSimdLevel(detectSimdLevel());
+}
+
+// Um nível acima do suportado pela CPU cai para o melhor disponível.
+void BatchEvaluator::setSimdLevel(SimdLevel requested) {
+    SimdLevel best = detectSimdLevel();
+    level = static_cast<int>(requested) > static_cast<int>(best) ? best : requested;
+
+    kernels = SCALAR_KERNELS;
+#if MC_SIMD_AVAILABLE
+    if (level == SimdLevel::AVX2) kernels = AVX2_KERNELS;
+    if (level == SimdLevel::AVX512) kernels = AVX512_KERNELS;
+#endif
+}
+
+// Blocos do frame necessários no pior caminho de chamadas, como no JIT.
+// Funções que alcançam um ciclo de chamadas nunca terminam e ficam marcadas.
+uint32_t BatchEvaluator::computeStackNeed(uint32_t index, std::vector<uint8_t> &state) {
+    if (state[index] == 1) return RECURSIVE;
+    if (state[index] == 2) return stackNeeds[index];
+
+    state[index] = 1;
+    const FunctionCode &fn = program.functions[index];
+    uint32_t deepest = 0;
+    bool recursive = false;
+    for (const auto &ins : fn.code) {
+        if (ins.op == OpCode::ARG && ins.dst + 1 > deepest) deepest = ins.dst + 1;
+        if (ins.op == OpCode::CALL) {
+            uint32_t callee = computeStackNeed(ins.a, state);
+            if (callee == RECURSIVE) recursive = true;
+            else if (callee > deepest) deepest = callee;
+        }
+    }
+    state[index] = 2;
+    stackNeeds[index] = recursive ? RECURSIVE : fn.numRegs + deepest;
+    return stackNeeds[index];
+}
+
+uint32_t BatchEvaluator::functionIndex(const Program &program, const std::string &name) {
+    Symbol symbol = Symbols::find(name);
+    for (uint32_t i = 0; symbol != Symbols::NONE && i < program.functions.size(); ++i) {
+        if (program.functions[i].symbol == symbol) return i;
+    }
+    throw std::runtime_error("função '" + name + "' não encontrada.");
+}
+
+inline const double* BatchEvaluator::operandTile(uint32_t operand, double *frame) const {
+    size_t offset = static_cast<size_t>(operandIndex(operand)) * TILE;
+    switch (operandKind(operand)) {
+        case OperandKind::REG: return frame + offset;
+        case OperandKind::GLOBAL: return globalTiles.data() + offset;
+        case OperandKind::CONST: return constTiles.data() + offset;
+    }
+    return zeroTile.data();
+}
+
+// Funções só escrevem em registradores do próprio frame e nos argumentos da
+// próxima chamada, então o destino é sempre um bloco do frame.
+const double* BatchEvaluator::runTile(const FunctionCode &fn, double *frame, size_t n) {
+    auto reg = [&](uint32_t operand) {
+        return frame + static_cast<size_t>(operandIndex(operand)) * TILE;
+    };
+    auto copy = [&](double *dst, const double *src) {
+        if (dst != src) std::memcpy(dst, src, n * sizeof(double));
+    };
+
+    for (const auto &ins : fn.code) {
+        const double *a = ins.op == OpCode::CALL ? nullptr : operandTile(ins.a, frame);
+        switch (ins.op) {
+            case OpCode::MOV: copy(reg(ins.dst), a); break;
+            case OpCode::ADD: kernels.add(reg(ins.dst), a, operandTile(ins.b, frame), n); break;
+            case OpCode::SUB: kernels.sub(reg(ins.dst), a, operandTile(ins.b, frame), n); break;
+            case OpCode::MUL: kernels.mul(reg(ins.dst), a, operandTile(ins.b, frame), n); break;
+            case OpCode::DIV: kernels.div(reg(ins.dst), a, operandTile(ins.b, frame), n); break;
+            case OpCode::POW: kernels.pow(reg(ins.dst), a, operandTile(ins.b, frame), n); break;
+            case OpCode::NEG: kernels.neg(reg(ins.dst), a, nullptr, n); break;
+            case OpCode::ARG:
+                copy(frame + static_cast<size_t>(fn.numRegs + ins.dst) * TILE, a);
+                break;
+            case OpCode::CALL: {
+                double *callee = frame + static_cast<size_t>(fn.numRegs) * TILE;
+                copy(reg(ins.dst), runTile(program.functions[ins.a], callee, n));
+                break;
+            }
+            case OpCode::RET:
+                return a;
+            case OpCode::PRINT:
+                break;
+        }
+    }
+    return zeroTile.data();
+}
+
+void BatchEvaluator::evaluate(uint32_t function, const std::vector<const double*> &columns,
+                              size_t rows, double *out) {
+    const FunctionCode &fn = program.functions.at(function);
+    if (columns.size() != fn.params.size()) {
+        throw std::runtime_error("função '" + fn.name + "' esperava " +
+                                 std::to_string(fn.params.size()) + " colunas, recebeu " +
+                                 std::to_string(columns.size()) + ".");
+    }
+    if (stackNeeds[function] == RECURSIVE) {
+        throw std::runtime_error("função '" + fn.name + "' é recursiva e não pode ser avaliada em lote.");
+    }
+
+    stack.resize(static_cast<size_t>(stackNeeds[function]) * TILE);
+    double *frame = stack.data();
+
+    for (size_t base = 0; base < rows; base += TILE) {
+        size_t n = rows - base < TILE ? rows - base : TILE;
+        for (size_t p = 0; p < columns.size(); ++p) {
+            std::memcpy(frame + p * TILE, columns[p] + base, n * sizeof(double));
+        }
+        const double *result = runTile(fn, frame, n);
+        std::memcpy(out + base, result, n * sizeof(double));
+    }
+}
@@ -0,0 +1,116 @@
+#include "../include/bytecode.h"
+#include <charconv>
+
+const char* opCodeSymbol(OpCode op) {
+    switch (op) {
+        case OpCode::ADD: return "+";
+        case OpCode::SUB: return "-";
+        case OpCode::MUL: return "*";
+        case OpCode::DIV: return "/";
+        case OpCode::POW: return "^";
+        case OpCode::NEG: return "-";
+        case OpCode::MOV: return "mov";
+        case OpCode::ARG: return "arg";
+        case OpCode::CALL: return "call";
+        case OpCode::RET: return "return";
+        case OpCode::PRINT: return "print";
+    }
+    return "?";
+}
+
+std::string formatNumber(double value) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    return std::string(buf, res.ptr);
+}
+
+std::string operandName(const Program &program, const FunctionCode &fn, uint32_t operand) {
+    uint32_t index = operandIndex(operand);
+    switch (operandKind(operand)) {
+        case OperandKind::REG:
+            if (index < fn.params.size()) return fn.params[index];
+            return "t" + std::to_string(index - fn.params.size());
+        case OperandKind::GLOBAL:
+            return program.globals[index];
+        case OperandKind::CONST:
+            return formatNumber(program.constants[index]);
+    }
+    return "?";
+}
+
+std::string disassemble(const Program &program, const FunctionCode &fn, const Instruction &ins) {
+    switch (ins.op) {
+        case OpCode::MOV:
+            return operandName(program, fn, ins.dst) + " = " + operandName(program, fn, ins.a);
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL: case OpCode::DIV: case OpCode::POW:
+            return operandName(program, fn, ins.dst) + " = " + operandName(program, fn, ins.a) +
+                   " " + opCodeSymbol(ins.op) + " " + operandName(program, fn, ins.b);
+        case OpCode::NEG:
+            return operandName(program, fn, ins.dst) + " = -" + operandName(program, fn, ins.a);
+        case OpCode::ARG:
+            return "arg" + std::to_string(ins.dst) + " = " + operandName(program, fn, ins.a);
+        case OpCode::CALL:
+            return operandName(program, fn, ins.dst) + " = call " + program.functions[ins.a].name +
+                   " " + std::to_string(ins.b);
+        case OpCode::RET:
+            return "return " + operandName(program, fn, ins.a);
+        case OpCode::PRINT:
+            return "print " + operandName(program, fn, ins.a);
+    }
+    return "?";
+}
+
+std::vector<std::string> disassembleProgram(const Program &program) {
+    std::vector<std::string> lines;
+    lines.push_back("=== CÓDIGO INTERMEDIÁRIO (TRÊS ENDEREÇOS) ===");
+
+    for (const auto &fn : program.functions) {
+        lines.push_back("func_" + fn.name + ":");
+        for (const auto &param : fn.params) {
+            lines.push_back("  param " + param);
+        }
+        for (const auto &ins : fn.code) {
+            lines.push_back("  " + disassemble(program, fn, ins));
+        }
+        lines.push_back("end_" + fn.name + ":");
+        lines.push_back("");
+    }
+
+    for (const auto &ins : program.main.code) {
+        bool statement = ins.op == OpCode::PRINT ||
+                         (ins.op != OpCode::ARG && operandKind(ins.dst) == OperandKind::GLOBAL);
+        lines.push_back((statement ? "" : "  ") + disassemble(program, program.main, ins));
+    }
+
+    lines.push_back("");
+    return lines;
+}
+
+std::vector<char> functionsReadingGlobals(const Program &program) {
+    auto isGlobal = [](uint32_t operand) { return operandKind(operand) == OperandKind::GLOBAL; };
+    std::vector<char> reads(program.functions.size(), 0);
+    for (size_t i = 0; i < program.functions.size(); ++i) {
+        for (const auto &ins : program.functions[i].code) {
+            bool binary = ins.op >= OpCode::ADD && ins.op <= OpCode::POW;
+            if (ins.op != OpCode::CALL && (isGlobal(ins.a) || (binary && isGlobal(ins.b)))) {
+                reads[i] = 1;
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < program.functions.size(); ++i) {
+            if (reads[i]) continue;
+            for (const auto &ins : program.functions[i].code) {
+                if (ins.op == OpCode::CALL && reads[ins.a]) {
+                    reads[i] = 1;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return reads;
+}
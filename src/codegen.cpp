@@ -1,98 +1,364 @@
 #include "../include/codegen.h"
+#include "../include/thread_pool.h"
+#include "../include/trace.h"
+#include <algorithm>
 #include <iostream>
+#include <cstring>
 
-CodeGenerator::CodeGenerator() : tempCounter(0) {}
+CodeGenerator::CodeGenerator()
+    : current(nullptr), irOptimization(true), threads(0), shared(nullptr) {}
 
-std::string CodeGenerator::newTemp() {
-    return "t" + std::to_string(tempCounter++);
+uint32_t CodeGenerator::slotOperand(const Slot &slot, Symbol name) {
+    if (slot.kind == SlotKind::GLOBAL) {
+        if (slot.index >= program.globals.size()) program.globals.resize(slot.index + 1);
+        if (program.globals[slot.index].empty()) program.globals[slot.index] = Symbols::name(name);
+        return makeOperand(OperandKind::GLOBAL, slot.index);
+    }
+
+    if (slot.index + 1 > current->numRegs) current->numRegs = slot.index + 1;
+    return makeOperand(OperandKind::REG, slot.index);
+}
+
+uint32_t CodeGenerator::constant(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    auto it = constantIndex.find(bits);
+    if (it != constantIndex.end()) return makeOperand(OperandKind::CONST, it->second);
+
+    uint32_t index = static_cast<uint32_t>(program.constants.size());
+    program.constants.push_back(value);
+    constantIndex[bits] = index;
+    return makeOperand(OperandKind::CONST, index);
+}
+
+void CodeGenerator::emit(const Instruction &ins) {
+    current->code.push_back(ins);
 }
 
 void CodeGenerator::generateCode(const std::vector<NodePtr> &ast) {
-    codeLines.clear();
-    tempCounter = 0;
-    
-    codeLines.push_back("=== CÓDIGO INTERMEDIÁRIO (TRÊS ENDEREÇOS) ===");
-    
-    
+    program = Program();
+    functionIndex.clear();
+    constantIndex.clear();
+
     for (const auto &node : ast) {
-        if (auto funcDecl = dynamic_cast<FuncDeclNode*>(node.get())) {
-            processFunctionDeclaration(funcDecl);
+        if (auto funcDecl = nodeAs<FuncDeclNode>(node.get())) {
+            functionIndex[funcDecl->name] = static_cast<uint32_t>(program.functions.size());
+            program.functions.emplace_back();
         }
     }
-    
+
+    std::vector<FuncDeclNode*> decls;
+    for (const auto &node : ast) {
+        if (auto funcDecl = nodeAs<FuncDeclNode>(node.get())) decls.push_back(funcDecl);
+    }
+    if (decls.size() >= PARALLEL_MIN_FUNCTIONS && ThreadPool::resolveThreads(threads) > 1) {
+        generateFunctionsParallel(decls);
+    } else {
+        for (auto funcDecl : decls) processFunctionDeclaration(funcDecl);
+    }
+
+    current = &program.main;
+
     for (const auto &node : ast) {
         if (!node) continue;
-        if (dynamic_cast<FuncDeclNode*>(node.get())) continue;
-        
-        if (auto assign = dynamic_cast<AssignNode*>(node.get())) {
-            std::string value = processNode(assign->expr.get());
-            if (!value.empty()) {
-                codeLines.push_back(assign->name + " = " + value);
-            }
+        if (node->kind == NodeKind::FUNC_DECL) continue;
+        processStatement(node.get());
+    }
+
+    optimizeProgram();
+}
+
+void CodeGenerator::processStatement(const Node* node) {
+    if (auto assign = nodeAs<AssignNode>(node)) {
+        uint32_t value = processNode(assign->expr.get());
+        if (value != NO_OPERAND) {
+            emit({OpCode::MOV, slotOperand(assign->slot, assign->name), value, 0});
+        }
+    } else {
+        // expressão solta como comando: o valor é mostrado na execução
+        uint32_t value = processNode(node);
+        if (value != NO_OPERAND) {
+            emit({OpCode::PRINT, 0, value, 0});
         }
     }
-    
-    codeLines.push_back(""); 
 }
 
+uint32_t CodeGenerator::generateFunction(FuncDeclNode* funcDecl) {
+    auto [it, inserted] = functionIndex.try_emplace(funcDecl->name,
+                                                    static_cast<uint32_t>(program.functions.size()));
+    if (inserted) program.functions.emplace_back();
+    else program.functions[it->second] = FunctionCode();
+
+    processFunctionDeclaration(funcDecl);
+    return it->second;
+}
+
+FunctionCode CodeGenerator::generateStatement(const Node* node) {
+    program.main = FunctionCode();
+    current = &program.main;
+    if (node) processStatement(node);
+    return program.main;
+}
+
+void CodeGenerator::optimizeProgram() {
+    irStats = IrStats();
+    if (irOptimization) {
+        IrOptimizer optimizer;
+        optimizer.optimize(program);
+        irStats = optimizer.getStats();
+    }
+}
+
+
+uint32_t CodeGenerator::calleeIndex(Symbol name) const {
+    const auto &index = shared ? shared->functionIndex : functionIndex;
+    auto it = index.find(name);
+    return it != index.end() ? it->second : 0;
+}
+
+// Cada faixa contígua de declarações vira uma tarefa com um gerador próprio:
+// registradores já vêm resolvidos da análise semântica, então o que cada
+// corpo compartilha com os outros são só as tabelas de constantes e de nomes
+// de globais. A junção percorre as faixas em ordem e registra as constantes
+// na ordem em que apareceram, que é a mesma em que a geração serial as criaria.
+void CodeGenerator::generateFunctionsParallel(const std::vector<FuncDeclNode*> &decls) {
+    ThreadPool pool(threads);
+    size_t chunks = std::min(decls.size(), pool.size() * 4);
+    std::vector<CodeGenerator> workers(chunks);
+    std::vector<std::vector<FunctionCode>> bodies(chunks);
+
+    for (size_t c = 0; c < chunks; ++c) {
+        pool.submit([&, c] {
+            CodeGenerator &worker = workers[c];
+            worker.shared = this;
+            size_t begin = decls.size() * c / chunks;
+            size_t end = decls.size() * (c + 1) / chunks;
+            bodies[c].resize(end - begin);
+            for (size_t k = begin; k < end; ++k) {
+                worker.processFunctionDeclaration(decls[k], bodies[c][k - begin]);
+            }
+        });
+    }
+    pool.wait();
+
+    for (size_t c = 0; c < chunks; ++c) {
+        const Program &local = workers[c].program;
+        std::vector<uint32_t> constants;
+        constants.reserve(local.constants.size());
+        for (double value : local.constants) constants.push_back(constant(value));
+
+        auto remap = [&](uint32_t &operand) {
+            if (operand != NO_OPERAND && operandKind(operand) == OperandKind::CONST) {
+                operand = constants[operandIndex(operand)];
+            }
+        };
+
+        size_t begin = decls.size() * c / chunks;
+        for (size_t k = 0; k < bodies[c].size(); ++k) {
+            FunctionCode &fn = bodies[c][k];
+            for (auto &ins : fn.code) {
+                if (ins.op != OpCode::CALL) remap(ins.a);
+                if (ins.op >= OpCode::ADD && ins.op <= OpCode::POW) remap(ins.b);
+            }
+            program.functions[functionIndex[decls[begin + k]->name]] = std::move(fn);
+        }
+
+        if (local.globals.size() > program.globals.size()) program.globals.resize(local.globals.size());
+        for (size_t g = 0; g < local.globals.size(); ++g) {
+            if (program.globals[g].empty()) program.globals[g] = local.globals[g];
+        }
+    }
+}
 
 void CodeGenerator::processFunctionDeclaration(FuncDeclNode* funcDecl) {
-    codeLines.push_back("func_" + funcDecl->name + ":");
-    
-    for (const auto& param : funcDecl->params) {
-        codeLines.push_back("  param " + param);
-    }
-    
-    std::string bodyResult = processNode(funcDecl->body.get());
-    if (!bodyResult.empty()) {
-        codeLines.push_back("  return " + bodyResult);
-    }
-    
-    codeLines.push_back("end_" + funcDecl->name + ":");
-    codeLines.push_back(""); 
-}
-
-std::string CodeGenerator::processNode(const Node* node) {
-    if (!node) return "";
-    
-    if (auto num = dynamic_cast<const NumberNode*>(node)) {
-        return num->value;
-    }
-    else if (auto var = dynamic_cast<const VarNode*>(node)) {
-        return var->name;
-    }
-    else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
-        std::string left = processNode(binary->left.get());
-        std::string right = processNode(binary->right.get());
-        
-        if (!left.empty() && !right.empty()) {
-            std::string temp = newTemp();
-            codeLines.push_back("  " + temp + " = " + left + " " + binary->op + " " + right);
+    processFunctionDeclaration(funcDecl, program.functions[functionIndex[funcDecl->name]]);
+}
+
+void CodeGenerator::processFunctionDeclaration(FuncDeclNode* funcDecl, FunctionCode &target) {
+    current = &target;
+    current->symbol = funcDecl->name;
+    current->name = Symbols::name(funcDecl->name);
+    for (Symbol param : funcDecl->params) current->params.emplace_back(Symbols::name(param));
+    current->numRegs = funcDecl->frameSize;
+
+    uint32_t bodyResult = processNode(funcDecl->body.get());
+    if (bodyResult != NO_OPERAND) {
+        emit({OpCode::RET, 0, bodyResult, 0});
+    }
+}
+
+static OpCode binaryOpCode(Operator op) {
+    switch (op) {
+        case Operator::ADD: return OpCode::ADD;
+        case Operator::SUB: return OpCode::SUB;
+        case Operator::MUL: return OpCode::MUL;
+        case Operator::DIV: return OpCode::DIV;
+        default: return OpCode::POW;
+    }
+}
+
+uint32_t CodeGenerator::processNode(const Node* node) {
+    if (!node) return NO_OPERAND;
+
+    switch (node->kind) {
+        case NodeKind::NUMBER:
+            return constant(static_cast<const NumberNode*>(node)->number());
+        case NodeKind::VAR: {
+            auto var = static_cast<const VarNode*>(node);
+            return slotOperand(var->slot, var->name);
+        }
+        case NodeKind::BINARY_OP: {
+            auto binary = static_cast<const BinaryOpNode*>(node);
+            uint32_t left = processNode(binary->left.get());
+            uint32_t right = processNode(binary->right.get());
+
+            if (left != NO_OPERAND && right != NO_OPERAND) {
+                uint32_t temp = slotOperand(binary->slot);
+                emit({binaryOpCode(binary->op), temp, left, right});
+                return temp;
+            }
+            break;
+        }
+        case NodeKind::UNARY_OP: {
+            auto unary = static_cast<const UnaryOpNode*>(node);
+            uint32_t operand = processNode(unary->operand.get());
+
+            if (operand != NO_OPERAND) {
+                uint32_t temp = slotOperand(unary->slot);
+                emit({OpCode::NEG, temp, operand, 0});
+                return temp;
+            }
+            break;
+        }
+        case NodeKind::FUNC_CALL: {
+            auto funcCall = static_cast<const FuncCallNode*>(node);
+            std::vector<uint32_t> args;
+            args.reserve(funcCall->args.size());
+            for (const auto &arg : funcCall->args) {
+                args.push_back(processNode(arg.get()));
+            }
+
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (args[i] != NO_OPERAND) {
+                    emit({OpCode::ARG, static_cast<uint32_t>(i), args[i], 0});
+                }
+            }
+
+            uint32_t temp = slotOperand(funcCall->slot);
+            emit({OpCode::CALL, temp, calleeIndex(funcCall->name),
+                  static_cast<uint32_t>(funcCall->args.size())});
             return temp;
         }
+        default:
+            break;
+    }
+
+    return NO_OPERAND;
+}
+
+void CodeGenerator::generateCode(const FlatAst &ast) {
+    program = Program();
+    functionIndex.clear();
+    constantIndex.clear();
+
+    for (const auto &st : ast.statements) {
+        if (ast.kinds[st.first] == FlatKind::FUNC_DECL) {
+            functionIndex[ast.a[st.first]] = static_cast<uint32_t>(program.functions.size());
+            program.functions.emplace_back();
+        }
+    }
+
+    // operando com o resultado de cada nó; os filhos sempre vêm antes do pai
+    std::vector<uint32_t> operands(ast.nodeCount(), NO_OPERAND);
+
+    for (const auto &st : ast.statements) {
+        uint32_t decl = st.first;
+        if (ast.kinds[decl] != FlatKind::FUNC_DECL) continue;
+
+        Symbol name = ast.a[decl];
+        uint32_t list = ast.b[decl];
+        current = &program.functions[functionIndex[name]];
+        current->symbol = name;
+        current->name = Symbols::name(name);
+        for (uint32_t i = 1; i <= ast.lists[list]; ++i) {
+            current->params.emplace_back(Symbols::name(ast.lists[list + i]));
+        }
+        current->numRegs = ast.slotIndices[decl];
+
+        for (uint32_t node = st.first + 1; node <= st.last; ++node) {
+            operands[node] = processFlatNode(ast, node, operands);
+        }
+        if (operands[st.last] != NO_OPERAND) {
+            emit({OpCode::RET, 0, operands[st.last], 0});
+        }
+    }
+
+    current = &program.main;
+
+    for (const auto &st : ast.statements) {
+        if (ast.kinds[st.first] == FlatKind::FUNC_DECL) continue;
+
+        for (uint32_t node = st.first; node <= st.last; ++node) {
+            operands[node] = processFlatNode(ast, node, operands);
+        }
+        // expressão solta como comando: o valor é mostrado na execução
+        if (ast.kinds[st.last] != FlatKind::ASSIGN && operands[st.last] != NO_OPERAND) {
+            emit({OpCode::PRINT, 0, operands[st.last], 0});
+        }
     }
-    else if (auto funcCall = dynamic_cast<const FuncCallNode*>(node)) {
-        std::string argsStr;
-        for (size_t i = 0; i < funcCall->args.size(); ++i) {
-            std::string arg = processNode(funcCall->args[i].get());
-            if (!arg.empty()) {
-                codeLines.push_back("  arg" + std::to_string(i) + " = " + arg);
-                if (i > 0) argsStr += ", ";
-                argsStr += arg;
+
+    optimizeProgram();
+}
+
+uint32_t CodeGenerator::processFlatNode(const FlatAst &ast, uint32_t node,
+                                        const std::vector<uint32_t> &operands) {
+    switch (ast.kinds[node]) {
+        case FlatKind::NUMBER:
+            return constant(ast.numbers[ast.a[node]]);
+        case FlatKind::VAR:
+            return slotOperand(ast.slot(node), ast.a[node]);
+        case FlatKind::BINARY: {
+            uint32_t left = operands[ast.a[node]];
+            uint32_t right = operands[ast.b[node]];
+            if (left == NO_OPERAND || right == NO_OPERAND) return NO_OPERAND;
+            uint32_t temp = slotOperand(ast.slot(node));
+            emit({binaryOpCode(ast.ops[node]), temp, left, right});
+            return temp;
+        }
+        case FlatKind::UNARY: {
+            uint32_t operand = operands[ast.a[node]];
+            if (operand == NO_OPERAND) return NO_OPERAND;
+            uint32_t temp = slotOperand(ast.slot(node));
+            emit({OpCode::NEG, temp, operand, 0});
+            return temp;
+        }
+        case FlatKind::CALL: {
+            uint32_t list = ast.b[node];
+            uint32_t count = ast.lists[list];
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t arg = operands[ast.lists[list + 1 + i]];
+                if (arg != NO_OPERAND) emit({OpCode::ARG, i, arg, 0});
+            }
+            uint32_t temp = slotOperand(ast.slot(node));
+            emit({OpCode::CALL, temp, functionIndex[ast.a[node]], count});
+            return temp;
+        }
+        case FlatKind::ASSIGN: {
+            uint32_t value = operands[ast.b[node]];
+            if (value != NO_OPERAND) {
+                emit({OpCode::MOV, slotOperand(ast.slot(node), ast.a[node]), value, 0});
             }
+            return NO_OPERAND;
         }
-        
-        std::string temp = newTemp();
-        codeLines.push_back("  " + temp + " = call " + funcCall->name + " " + std::to_string(funcCall->args.size()));
-        return temp;
+        case FlatKind::FUNC_DECL:
+            break;
     }
-    
-    return "";
+    return NO_OPERAND;
 }
 
 void CodeGenerator::printCode() const {
-    std::cout << "\n"; 
-    for (const auto &line : codeLines) {
-        std::cout << line << std::endl;
+    Trace::out() << "\n";
+    for (const auto &line : disassembleProgram(program)) {
+        Trace::out() << line << '\n';
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,97 @@
+#include "../include/flat_ast.h"
+#include "../include/bytecode.h"
+#include <charconv>
+
+uint32_t FlatAst::addNode(FlatKind kind, Operator op, uint32_t first, uint32_t second, Type type) {
+    uint32_t index = static_cast<uint32_t>(kinds.size());
+    kinds.push_back(kind);
+    ops.push_back(op);
+    types.push_back(type);
+    a.push_back(first);
+    b.push_back(second);
+    slotKinds.push_back(SlotKind::NONE);
+    slotIndices.push_back(0);
+    return index;
+}
+
+uint32_t FlatAst::addNumber(std::string_view text) {
+    double value = 0.0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    Type type = text.find('.') != std::string_view::npos ? Type::FLOAT : Type::INT;
+
+    uint32_t literal = static_cast<uint32_t>(numbers.size());
+    numbers.push_back(value);
+    return addNode(FlatKind::NUMBER, Operator::NONE, literal, 0, type);
+}
+
+void FlatAst::setSlot(uint32_t node, const Slot &slot) {
+    slotKinds[node] = slot.kind;
+    slotIndices[node] = slot.index;
+}
+
+size_t FlatAst::bytesUsed() const {
+    return kinds.capacity() * sizeof(FlatKind) + ops.capacity() * sizeof(Operator) +
+           types.capacity() * sizeof(Type) + a.capacity() * sizeof(uint32_t) +
+           b.capacity() * sizeof(uint32_t) + slotKinds.capacity() * sizeof(SlotKind) +
+           slotIndices.capacity() * sizeof(uint32_t) + numbers.capacity() * sizeof(double) +
+           lists.capacity() * sizeof(uint32_t) +
+           statements.capacity() * sizeof(FlatStatement);
+}
+
+void FlatAst::prettyPrint() const {
+    for (const auto &st : statements) prettyPrint(statementRoot(st), 0);
+}
+
+void FlatAst::prettyPrint(uint32_t node, int indent) const {
+    std::ostream &out = Trace::out();
+    printIndent(indent);
+
+    std::string typeStr = typeToString(types[node]);
+    auto typed = [&](std::string_view label, std::string_view text) {
+        out << label << "(" << text;
+        if (!typeStr.empty()) out << " : " << typeStr;
+        out << ")\n";
+    };
+
+    switch (kinds[node]) {
+        case FlatKind::NUMBER:
+            typed("Number", formatNumber(numbers[a[node]]));
+            break;
+        case FlatKind::VAR:
+            typed("Var", Symbols::name(a[node]));
+            break;
+        case FlatKind::BINARY:
+            typed("BinaryOp", operatorSymbol(ops[node]));
+            prettyPrint(a[node], indent + 1);
+            prettyPrint(b[node], indent + 1);
+            break;
+        case FlatKind::UNARY:
+            typed("UnaryOp", operatorSymbol(ops[node]));
+            prettyPrint(a[node], indent + 1);
+            break;
+        case FlatKind::CALL: {
+            typed("FuncCall", Symbols::name(a[node]));
+            uint32_t count = lists[b[node]];
+            for (uint32_t i = 1; i <= count; ++i) prettyPrint(lists[b[node] + i], indent + 1);
+            break;
+        }
+        case FlatKind::ASSIGN:
+            out << "Assign(" << Symbols::name(a[node]) << ")\n";
+            prettyPrint(b[node], indent + 1);
+            break;
+        case FlatKind::FUNC_DECL: {
+            typed("FuncDecl", Symbols::name(a[node]));
+            uint32_t count = lists[b[node]];
+            printIndent(indent + 1);
+            out << "Params:\n";
+            for (uint32_t i = 1; i <= count; ++i) {
+                printIndent(indent + 2);
+                out << Symbols::name(lists[b[node] + i]) << "\n";
+            }
+            printIndent(indent + 1);
+            out << "Body:\n";
+            prettyPrint(lists[b[node] + count + 1], indent + 2);
+            break;
+        }
+    }
+}
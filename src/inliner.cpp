@@ -0,0 +1,201 @@
+#include "../include/inliner.h"
+
+Inliner::Inliner(Arena &a, size_t b) : arena(a), budget(b), inlinedCalls(0) {}
+
+static size_t treeSize(const Node *node) {
+    if (!node) return 0;
+
+    size_t total = 1;
+    forEachChild(*node, [&](const NodePtr &child) { total += treeSize(child.get()); });
+    return total;
+}
+
+static void collectCalls(const Node *node, std::vector<Symbol> &out) {
+    if (!node) return;
+
+    if (auto call = nodeAs<FuncCallNode>(node)) out.push_back(call->name);
+    forEachChild(*node, [&](const NodePtr &child) { collectCalls(child.get(), out); });
+}
+
+// Conta as ocorrências de cada nome de variável na expressão.
+static void collectVars(const Node *node, std::unordered_map<Symbol, size_t> &uses) {
+    if (!node) return;
+
+    if (auto var = nodeAs<VarNode>(node)) ++uses[var->name];
+    forEachChild(*node, [&](const NodePtr &child) { collectVars(child.get(), uses); });
+}
+
+static bool isLeaf(const Node *node) {
+    return node->kind == NodeKind::VAR || node->kind == NodeKind::NUMBER;
+}
+
+// Copia a expressão trocando cada parâmetro pela cópia do argumento.
+NodePtr Inliner::cloneExpr(const Node *node,
+                           const std::unordered_map<Symbol, const Node*> &args) {
+    if (!node) return nullptr;
+
+    NodePtr copy;
+    switch (node->kind) {
+        case NodeKind::NUMBER:
+            copy = makeNode<NumberNode>(arena, static_cast<const NumberNode*>(node)->value);
+            break;
+        case NodeKind::VAR: {
+            auto var = static_cast<const VarNode*>(node);
+            auto found = args.find(var->name);
+            if (found != args.end()) return cloneExpr(found->second, {});
+            copy = makeNode<VarNode>(arena, var->name);
+            break;
+        }
+        case NodeKind::BINARY_OP: {
+            auto binary = static_cast<const BinaryOpNode*>(node);
+            copy = makeNode<BinaryOpNode>(arena, binary->op, cloneExpr(binary->left.get(), args),
+                                                cloneExpr(binary->right.get(), args));
+            break;
+        }
+        case NodeKind::UNARY_OP: {
+            auto unary = static_cast<const UnaryOpNode*>(node);
+            copy = makeNode<UnaryOpNode>(arena, unary->op, cloneExpr(unary->operand.get(), args));
+            break;
+        }
+        case NodeKind::FUNC_CALL: {
+            auto call = static_cast<const FuncCallNode*>(node);
+            std::pmr::vector<NodePtr> callArgs(&arena);
+            for (const auto &arg : call->args) callArgs.push_back(cloneExpr(arg.get(), args));
+            copy = makeNode<FuncCallNode>(arena, call->name, std::move(callArgs));
+            break;
+        }
+        default:
+            return nullptr;
+    }
+
+    copy->type = node->type;
+    return copy;
+}
+
+// Uma função é recursiva se alcança a si mesma pelo grafo de chamadas.
+void Inliner::findRecursive() {
+    std::unordered_map<Symbol, std::vector<Symbol>> callees;
+    for (const auto &entry : functions) {
+        collectCalls(entry.second->body.get(), callees[entry.first]);
+    }
+
+    for (const auto &entry : functions) {
+        std::unordered_set<Symbol> visited;
+        std::vector<Symbol> pending = callees[entry.first];
+        while (!pending.empty()) {
+            Symbol name = pending.back();
+            pending.pop_back();
+            if (name == entry.first) {
+                recursive.insert(name);
+                break;
+            }
+            if (!visited.insert(name).second) continue;
+            auto next = callees.find(name);
+            if (next != callees.end()) {
+                pending.insert(pending.end(), next->second.begin(), next->second.end());
+            }
+        }
+    }
+}
+
+// Expande primeiro as funções chamadas, para que o corpo copiado já venha
+// com as próprias chamadas expandidas.
+void Inliner::processFunction(FuncDeclNode *decl) {
+    if (!processed.insert(decl->name).second) return;
+
+    std::vector<Symbol> calls;
+    collectCalls(decl->body.get(), calls);
+    for (const auto &name : calls) {
+        auto found = functions.find(name);
+        if (found != functions.end()) processFunction(found->second);
+    }
+
+    decl->body = inlineCalls(std::move(decl->body), decl, functionPositions[decl->name]);
+}
+
+NodePtr Inliner::expand(ArenaPtr<FuncCallNode> call, const FuncDeclNode *callee,
+                        const FuncDeclNode *context, size_t position) {
+    std::unordered_map<Symbol, size_t> uses;
+    collectVars(callee->body.get(), uses);
+
+    std::unordered_map<Symbol, const Node*> args;
+    for (size_t i = 0; i < callee->params.size(); ++i) {
+        const Node *arg = call->args[i].get();
+        // argumento composto usado mais de uma vez seria calculado de novo
+        if (uses[callee->params[i]] > 1 && !isLeaf(arg)) return call;
+        args[callee->params[i]] = arg;
+        uses.erase(callee->params[i]);
+    }
+
+    // Globais lidas pelo corpo não podem ser capturadas por parâmetros de
+    // mesmo nome da função onde a chamada está.
+    if (context) {
+        for (const auto &param : context->params) {
+            if (uses.count(param)) return call;
+        }
+    }
+
+    // O que sobra são globais, e a análise refeita só aceita as atribuídas
+    // antes do comando da chamada (a função chamada pode ter sido declarada
+    // depois da atribuição, a chamadora não).
+    for (const auto &use : uses) {
+        auto assigned = globalPositions.find(use.first);
+        if (assigned == globalPositions.end() || assigned->second >= position) return call;
+    }
+
+    ++inlinedCalls;
+    return cloneExpr(callee->body.get(), args);
+}
+
+NodePtr Inliner::inlineCalls(NodePtr node, const FuncDeclNode *context, size_t position) {
+    if (!node) return node;
+
+    forEachChild(*node, [&](NodePtr &child) { child = inlineCalls(std::move(child), context, position); });
+
+    if (auto call = nodeAs<FuncCallNode>(node.get())) {
+        auto found = functions.find(call->name);
+        if (found == functions.end() || recursive.count(call->name)) return node;
+
+        const FuncDeclNode *callee = found->second;
+        if (!callee->body || treeSize(callee->body.get()) > budget ||
+            callee->params.size() != call->args.size()) {
+            return node;
+        }
+
+        node.release();
+        size_t before = inlinedCalls;
+        NodePtr result = expand(ArenaPtr<FuncCallNode>(call), callee, context, position);
+        // o corpo copiado pode ter chamadas que só agora podem ser expandidas
+        // (por exemplo, uma que seria capturada dentro da função chamada)
+        if (inlinedCalls > before) result = inlineCalls(std::move(result), context, position);
+        return result;
+    }
+    return node;
+}
+
+void Inliner::run(std::vector<NodePtr> &ast) {
+    inlinedCalls = 0;
+    functions.clear();
+    functionPositions.clear();
+    globalPositions.clear();
+    recursive.clear();
+    processed.clear();
+    if (budget == 0) return;
+
+    for (size_t i = 0; i < ast.size(); ++i) {
+        if (auto decl = nodeAs<FuncDeclNode>(ast[i].get())) {
+            functions[decl->name] = decl;
+            functionPositions[decl->name] = i;
+        } else if (auto assign = nodeAs<AssignNode>(ast[i].get())) {
+            globalPositions.emplace(assign->name, i);
+        }
+    }
+    findRecursive();
+
+    for (const auto &node : ast) {
+        if (auto decl = nodeAs<FuncDeclNode>(node.get())) processFunction(decl);
+    }
+    for (size_t i = 0; i < ast.size(); ++i) {
+        if (ast[i]->kind != NodeKind::FUNC_DECL) ast[i] = inlineCalls(std::move(ast[i]), nullptr, i);
+    }
+}
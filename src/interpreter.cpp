@@ -1,315 +1,638 @@
 #include "../include/interpreter.h"
-#include <sstream>
+#include "../include/thread_pool.h"
+#include "../include/trace.h"
+#include <atomic>
+#include <cassert>
 #include <cmath>
-#include <algorithm>
-#include <unordered_map>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <iostream>
-#include <cctype>
-
-Interpreter::Interpreter(const std::vector<std::string>& lines) {
-    
-    bool inFunc = false;
-    std::string currentFuncName;
-    std::vector<std::string> currentFuncBody;
-
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::string raw = lines[i];
-        
-        size_t start = raw.find_first_not_of(" \t\r\n");
-        std::string line = (start == std::string::npos) ? std::string() : raw.substr(start);
-
-        if (line.empty()) continue;
-        
-        if (!inFunc && line.rfind("func_", 0) == 0 && line.back() == ':') {
-            inFunc = true;
-            currentFuncName = line.substr(5, line.size() - 6); 
-            currentFuncBody.clear();
-            continue;
-        }
-        
-        if (inFunc && line.rfind("end_", 0) == 0 && line.back() == ':') {
-            FunctionIR fir;
-            for (const auto &l : currentFuncBody) {
-                size_t s = l.find_first_not_of(" \t");
-                std::string tl = (s == std::string::npos) ? std::string() : l.substr(s);
-                if (tl.rfind("param ", 0) == 0) {
-                    std::istringstream iss(tl);
-                    std::string kw, pname;
-                    iss >> kw >> pname;
-                    if (!pname.empty()) fir.params.push_back(pname);
-                }
-            }
-            fir.body = currentFuncBody;
-            functions[currentFuncName] = std::move(fir);
 
-            inFunc = false;
-            currentFuncName.clear();
-            currentFuncBody.clear();
-            continue;
-        }
+static constexpr double NOT_A_NUMBER = std::numeric_limits<double>::quiet_NaN();
 
-        if (inFunc) {
-            currentFuncBody.push_back(line);
-        } else {
-            
-            mainLines.push_back(line);
-        }
+Interpreter::Interpreter(const Program &prog, size_t stackSlots)
+    : program(prog), globals(prog.globals.size(), 0.0),
+      dispatch(MC_COMPUTED_GOTO ? DispatchMode::THREADED : DispatchMode::SWITCH),
+      trace(Trace::enabled(Trace::EXEC)), threadedHandlers(nullptr),
+      stack(nullptr), reservedArgs(0), scheduleThreads(0) {
+
+    // O frame do programa principal cresce com o número de comandos (sem
+    // otimização cada um deixa seus temporários), então fica fora da conta.
+    stackSlots += program.main.numRegs;
+    stack.reset(new double[stackSlots]);
+    mainStack.end = stack.get() + stackSlots;
+
+    reserveArgs(program.main);
+    for (const auto &fn : program.functions) reserveArgs(fn);
+
+    exec.resize(program.functions.size());
+    for (size_t i = 0; i < program.functions.size(); ++i) {
+        decode(program.functions[i], exec[i]);
+    }
+    decode(program.main, execMain);
+
+#if MC_COMPUTED_GOTO
+    runThreaded(nullptr, nullptr, mainStack);
+#endif
+    bindHandlers();
+}
+
+static inline bool isBinary(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::SUB || op == OpCode::MUL ||
+           op == OpCode::DIV || op == OpCode::POW;
+}
+
+static inline bool readsOperand(const Instruction &ins, uint32_t operand) {
+    switch (ins.op) {
+        case OpCode::MOV: case OpCode::NEG: case OpCode::ARG:
+        case OpCode::RET: case OpCode::PRINT:
+            return ins.a == operand;
+        case OpCode::CALL:
+            return false;
+        default:
+            return ins.a == operand || ins.b == operand;
     }
-    
-    callStack.clear();
-    callStack.emplace_back(); 
 }
 
-static inline std::string trim(const std::string &s) {
-    size_t a = s.find_first_not_of(" \t\r\n");
-    if (a == std::string::npos) return "";
-    size_t b = s.find_last_not_of(" \t\r\n");
-    return s.substr(a, b - a + 1);
+static inline bool writesOperand(const Instruction &ins, uint32_t operand) {
+    return ins.op != OpCode::ARG && ins.op != OpCode::RET && ins.op != OpCode::PRINT &&
+           ins.dst == operand;
 }
 
-static inline bool startsWith(const std::string &s, const std::string &prefix) {
-    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+// Um temporário pode ser eliminado quando nenhuma instrução seguinte o lê
+// antes de ele ser redefinido (o código de cada função é linear). Uma única
+// passada de trás para frente marca as instruções que fazem a última leitura
+// do registrador em `a`, em vez de procurar adiante a cada candidato.
+static std::vector<char> lastReadOfA(const FunctionCode &fn) {
+    const auto &code = fn.code;
+    std::vector<char> last(code.size(), 0);
+    std::vector<char> live(fn.numRegs, 0);
+    auto isReg = [&](uint32_t operand) {
+        return operandKind(operand) == OperandKind::REG && operandIndex(operand) < live.size();
+    };
+
+    for (size_t p = code.size(); p-- > 0;) {
+        const Instruction &ins = code[p];
+        bool readsA = isReg(ins.a) && readsOperand(ins, ins.a);
+        bool readsB = isReg(ins.b) && readsOperand(ins, ins.b);
+        last[p] = readsA && !live[operandIndex(ins.a)];
+        if (isReg(ins.dst) && writesOperand(ins, ins.dst)) live[operandIndex(ins.dst)] = 0;
+        if (readsA) live[operandIndex(ins.a)] = 1;
+        if (readsB) live[operandIndex(ins.b)] = 1;
+    }
+    return last;
 }
 
-double Interpreter::getValue(const std::string& name) {
-    std::string n = name;
-    if (n.empty()) return 0.0;
+static inline ExecOp execBinary(OpCode op, ExecOp base) {
+    return static_cast<ExecOp>(static_cast<uint8_t>(base) +
+                               (static_cast<uint8_t>(op) - static_cast<uint8_t>(OpCode::ADD)));
+}
 
-    bool isNumber = false;
-    size_t idx = 0;
-    if (n[0] == '-' || n[0] == '+') idx = 1;
-    bool dotFound = false;
-    for (size_t i = idx; i < n.size(); ++i) {
-        if (n[i] == '.') {
-            if (dotFound) { isNumber = false; break; }
-            dotFound = true;
-            continue;
+void Interpreter::decode(const FunctionCode &fn, ExecFunction &out) const {
+    const auto &code = fn.code;
+    out.numRegs = fn.numRegs;
+    out.frameNeed = fn.numRegs;
+    out.native = nullptr;
+    out.code.clear();
+    out.argOperands.clear();
+
+    auto push = [&](ExecOp op, uint32_t dst, uint32_t a, uint32_t b, uint32_t c = 0) {
+        out.code.push_back({nullptr, op, dst, a, b, c});
+    };
+    std::vector<char> lastRead = lastReadOfA(fn);
+
+    for (size_t i = 0; i < code.size(); ++i) {
+        const Instruction &ins = code[i];
+
+        if (isBinary(ins.op) && i + 1 < code.size()) {
+            const Instruction &next = code[i + 1];
+            if (next.op == OpCode::RET && next.a == ins.dst) {
+                push(execBinary(ins.op, ExecOp::RET_ADD), 0, ins.a, ins.b);
+                ++i;
+                continue;
+            }
+            if (next.op == OpCode::MOV && next.a == ins.dst && lastRead[i + 1]) {
+                push(execBinary(ins.op, ExecOp::ADD), next.dst, ins.a, ins.b);
+                ++i;
+                continue;
+            }
         }
-        if (!std::isdigit((unsigned char)n[i])) {
-            isNumber = false;
-            break;
+
+        if (ins.op == OpCode::ARG) {
+            size_t j = i;
+            while (j < code.size() && code[j].op == OpCode::ARG && code[j].dst == j - i) ++j;
+            if (j < code.size() && code[j].op == OpCode::CALL && code[j].b == j - i) {
+                uint32_t offset = static_cast<uint32_t>(out.argOperands.size());
+                for (size_t k = i; k < j; ++k) out.argOperands.push_back(code[k].a);
+                push(ExecOp::CALLV, code[j].dst, code[j].a, code[j].b, offset);
+                i = j;
+                continue;
+            }
         }
-        isNumber = true;
-    }
-    if (isNumber) {
-        try {
-            return std::stod(n);
-        } catch (...) {
-            return 0.0;
+
+        switch (ins.op) {
+            case OpCode::MOV: push(ExecOp::MOV, ins.dst, ins.a, 0); break;
+            case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+            case OpCode::DIV: case OpCode::POW:
+                push(execBinary(ins.op, ExecOp::ADD), ins.dst, ins.a, ins.b);
+                break;
+            case OpCode::NEG: push(ExecOp::NEG, ins.dst, ins.a, 0); break;
+            case OpCode::ARG: push(ExecOp::ARG, ins.dst, ins.a, 0); break;
+            case OpCode::CALL: push(ExecOp::CALL, ins.dst, ins.a, ins.b); break;
+            case OpCode::RET: push(ExecOp::RET, 0, ins.a, 0); break;
+            case OpCode::PRINT: push(ExecOp::PRINT, 0, ins.a, 0); break;
         }
     }
-    
-    for (auto it = callStack.rbegin(); it != callStack.rend(); ++it) {
-        auto found = it->find(n);
-        if (found != it->end()) return found->second;
-    }
 
-    return 0.0;
+    push(ExecOp::END, 0, 0, 0);
+}
+
+void Interpreter::bindHandlers() {
+    for (auto &fn : exec) bindHandlers(fn);
+    bindHandlers(execMain);
 }
 
-void Interpreter::setValue(const std::string& name, double value) {
-    if (callStack.empty()) {
-        callStack.emplace_back();
+void Interpreter::bindHandlers(ExecFunction &fn) {
+    if (!threadedHandlers) return;
+    for (auto &ins : fn.code) ins.handler = threadedHandlers[static_cast<size_t>(ins.op)];
+}
+
+// Reserva espaço para os argumentos que o frame do topo escreve acima de si.
+void Interpreter::reserveArgs(const FunctionCode &fn) {
+    for (const auto &ins : fn.code) {
+        if (ins.op != OpCode::CALL || ins.b <= reservedArgs) continue;
+        uint32_t extra = ins.b - reservedArgs;
+        mainStack.end = mainStack.end - stack.get() > extra ? mainStack.end - extra : stack.get();
+        reservedArgs = ins.b;
     }
-    
-    callStack.back()[name] = value;
 }
 
-std::pair<bool,double> Interpreter::executeLines(const std::vector<std::string>& lines) {
-    for (const auto &raw : lines) {
-        std::string line = trim(raw);
-        if (line.empty()) continue;
-        
-        if (startsWith(line, "func_") || startsWith(line, "end_") || startsWith(line, "param ")) {
-            continue;
-        }
-        
-        if (startsWith(line, "return ")) {
-            std::string expr = trim(line.substr(7));
-            double val = getValue(expr);
-            return {true, val};
+size_t Interpreter::enableJit() {
+    jit = std::make_unique<JitCompiler>();
+    size_t compiled = jit->compile(program, globals.data());
+
+    for (uint32_t i = 0; i < exec.size(); ++i) {
+        if (NativeFunction native = jit->entry(i)) {
+            exec[i].native = native;
+            exec[i].frameNeed = jit->stackNeed(i);
         }
+    }
+    return compiled;
+}
 
-        std::istringstream iss(line);
-        std::string dest;
-        if (!(iss >> dest)) continue;
-        
-        if (!dest.empty() && dest.back() == ':') continue;
+// Um cache por função; a pilha de parâmetros do frame é a própria chave.
+// Funções que leem globais (direta ou indiretamente) ficam sem cache: o
+// resultado delas muda quando o programa reatribui a global.
+void Interpreter::enableMemo(uint32_t capacity) {
+    std::vector<char> readsGlobals = functionsReadingGlobals(program);
+    memos.clear();
+    memos.resize(exec.size());
+    for (uint32_t i = 0; i < exec.size(); ++i) {
+        if (readsGlobals[i]) continue;
+        uint32_t argc = static_cast<uint32_t>(program.functions[i].params.size());
+        memos[i] = std::make_unique<MemoCache>(argc, capacity);
+        exec[i].memo = memos[i].get();
+    }
+}
 
-        std::string eq;
-        if (!(iss >> eq)) continue;
+void Interpreter::setDispatchMode(DispatchMode mode) {
+    dispatch = (mode == DispatchMode::THREADED && !threadedHandlers) ? DispatchMode::SWITCH : mode;
+}
 
-        if (eq != "=") {
-            continue;
-        }
+static inline double divide(double v1, double v2) {
+    return v2 == 0.0 ? NOT_A_NUMBER : v1 / v2;
+}
+
+// Resultado de uma expressão usada como comando no programa principal.
+static void printResult(double value) {
+    Trace::out() << "resultado: " << value << '\n';
+}
 
-        std::string token1;
-        if (!(iss >> token1)) continue;
+static void printResult(CallStack &cs, double value) {
+    if (cs.printed) cs.printed->push_back(value);
+    else printResult(value);
+}
+
+static inline double applyBinary(OpCode op, double v1, double v2) {
+    switch (op) {
+        case OpCode::ADD: return v1 + v2;
+        case OpCode::SUB: return v1 - v2;
+        case OpCode::MUL: return v1 * v2;
+        case OpCode::DIV: return divide(v1, v2);
+        case OpCode::POW: return std::pow(v1, v2);
+        default: return 0.0;
+    }
+}
 
-        std::string token2;
-        if (!(iss >> token2)) {
-            double v = getValue(token1);
-            setValue(dest, v);
-            std::cout << "  " << dest << " = " << v << std::endl;
-            continue;
+double Interpreter::runTraced(const FunctionCode &fn, double *frame) {
+    double *bases[3] = {frame, globals.data(), program.constants.data()};
+    auto load = [&](uint32_t operand) -> double {
+        return bases[operand >> 30][operand & OPERAND_INDEX_MASK];
+    };
+    auto store = [&](uint32_t operand, double value) {
+        bases[operand >> 30][operand & OPERAND_INDEX_MASK] = value;
+    };
+
+    bool topLevel = &fn == &program.main;
+    std::ostream &out = Trace::out();
+
+    for (const auto &ins : fn.code) {
+        ++mainStack.counters.instructions;
+        if (topLevel) {
+            out << "Executando: " << disassemble(program, fn, ins) << '\n';
         }
 
-        std::string token3;
-        iss >> token3; 
-
-        if (token1 == "call") {
-            
-            std::string funcName = token2;
-            int numArgs = 0;
-            if (!token3.empty()) {
-                try { numArgs = std::stoi(token3); }
-                catch (...) { numArgs = 0; }
-            } else {
-                if (!(iss >> numArgs)) numArgs = 0;
+        switch (ins.op) {
+            case OpCode::MOV: {
+                double v = load(ins.a);
+                store(ins.dst, v);
+                out << "  " << operandName(program, fn, ins.dst) << " = " << v << '\n';
+                break;
             }
-
-            std::vector<double> argValues;
-            for (int i = 0; i < numArgs; ++i) {
-                std::string an = "arg" + std::to_string(i);
-                double av = getValue(an);
-                argValues.push_back(av);
+            case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+            case OpCode::DIV: case OpCode::POW: {
+                double v1 = load(ins.a);
+                double v2 = load(ins.b);
+                double res = applyBinary(ins.op, v1, v2);
+                store(ins.dst, res);
+                out << "  " << operandName(program, fn, ins.dst) << " = " << v1 << " "
+                    << opCodeSymbol(ins.op) << " " << v2 << " = " << res << '\n';
+                break;
             }
-
-            double callResult = 0.0;
-            if (!funcName.empty()) {
-                callResult = callFunction(funcName, argValues);
+            case OpCode::NEG: {
+                double v = -load(ins.a);
+                store(ins.dst, v);
+                out << "  " << operandName(program, fn, ins.dst) << " = " << v << '\n';
+                break;
             }
-
-            setValue(dest, callResult);
-            std::cout << "  " << dest << " = " << callResult << " (call " << funcName << ")\n";
-            continue;
-        } else if (token2 == "call") {
-            
-            std::string funcName = token3;
-            int numArgs = 0;
-            if (!(iss >> numArgs)) numArgs = 0;
-
-            std::vector<double> argValues;
-            for (int i = 0; i < numArgs; ++i) {
-                std::string an = "arg" + std::to_string(i);
-                double av = getValue(an);
-                argValues.push_back(av);
+            case OpCode::ARG: {
+                double v = load(ins.a);
+                frame[fn.numRegs + ins.dst] = v;
+                out << "  arg" << ins.dst << " = " << v << '\n';
+                break;
             }
-
-            double callResult = callFunction(funcName, argValues);
-            setValue(dest, callResult);
-            std::cout << "  " << dest << " = " << callResult << " (call " << funcName << ")\n";
-            continue;
-        } else {
-            
-            if (!token3.empty()) {
-                double v1 = getValue(token1);
-                double v2 = getValue(token3);
-                double res = 0.0;
-                if (token2 == "+") res = v1 + v2;
-                else if (token2 == "-") res = v1 - v2;
-                else if (token2 == "*") res = v1 * v2;
-                else if (token2 == "/") {
-                    if (v2 == 0.0) res = std::nan("");
-                    else res = v1 / v2;
-                } else if (token2 == "^") res = std::pow(v1, v2);
-                else {
-                    
-                    res = getValue(token1);
-                }
-                setValue(dest, res);
-                std::cout << "  " << dest << " = " << v1 << " " << token2 << " " << v2 << " = " << res << std::endl;
-                continue;
-            } else {
-                
-                double v1 = getValue(token1);
-                setValue(dest, v1);
-                std::cout << "  " << dest << " = " << v1 << std::endl;
-                continue;
+            case OpCode::CALL: {
+                double res = callFunction(ins.a, ins.b, frame + fn.numRegs);
+                store(ins.dst, res);
+                out << "  " << operandName(program, fn, ins.dst) << " = " << res
+                    << " (call " << program.functions[ins.a].name << ")\n";
+                break;
             }
+            case OpCode::RET:
+                return load(ins.a);
+            case OpCode::PRINT:
+                printResult(load(ins.a));
+                break;
         }
     }
 
-    return {false, 0.0};
+    return 0.0;
 }
 
-double Interpreter::callFunction(const std::string &name, const std::vector<double> &args) {
-    auto it = functions.find(name);
-    if (it == functions.end()) {
-        std::cerr << "Erro: função '" << name << "' não encontrada.\n";
-        return 0.0;
+// Entrada de chamada dos laços rápidos: a aridade já foi conferida pela
+// análise semântica, então resta apenas validar a pilha.
+inline const ExecFunction& Interpreter::enterCall(uint32_t index, double *frame, CallStack &cs) {
+    const ExecFunction &target = exec[index];
+    if (cs.depth >= MAX_CALL_DEPTH || frame + target.frameNeed > cs.end) {
+        checkFrame(program.functions[index].name, target.frameNeed, frame, cs);
     }
+    ++cs.depth;
+    return target;
+}
 
-    const FunctionIR &fir = it->second;
+#define LOAD(operand) bases[(operand) >> 30][(operand) & OPERAND_INDEX_MASK]
+
+template<bool Counted>
+double Interpreter::runSwitch(const ExecFunction &fn, double *frame, CallStack &cs) {
+    double *const bases[3] = {frame, globals.data(), program.constants.data()};
+    const ExecInstr *ip = fn.code.data();
+
+    for (;; ++ip) {
+        if constexpr (Counted) ++cs.counters.instructions;
+        switch (ip->op) {
+            case ExecOp::MOV: LOAD(ip->dst) = LOAD(ip->a); break;
+            case ExecOp::ADD: LOAD(ip->dst) = LOAD(ip->a) + LOAD(ip->b); break;
+            case ExecOp::SUB: LOAD(ip->dst) = LOAD(ip->a) - LOAD(ip->b); break;
+            case ExecOp::MUL: LOAD(ip->dst) = LOAD(ip->a) * LOAD(ip->b); break;
+            case ExecOp::DIV: LOAD(ip->dst) = divide(LOAD(ip->a), LOAD(ip->b)); break;
+            case ExecOp::POW: LOAD(ip->dst) = std::pow(LOAD(ip->a), LOAD(ip->b)); break;
+            case ExecOp::RET_ADD: return LOAD(ip->a) + LOAD(ip->b);
+            case ExecOp::RET_SUB: return LOAD(ip->a) - LOAD(ip->b);
+            case ExecOp::RET_MUL: return LOAD(ip->a) * LOAD(ip->b);
+            case ExecOp::RET_DIV: return divide(LOAD(ip->a), LOAD(ip->b));
+            case ExecOp::RET_POW: return std::pow(LOAD(ip->a), LOAD(ip->b));
+            case ExecOp::NEG: LOAD(ip->dst) = -LOAD(ip->a); break;
+            case ExecOp::ARG: frame[fn.numRegs + ip->dst] = LOAD(ip->a); break;
+            case ExecOp::CALL: {
+                double *callee = frame + fn.numRegs;
+                const ExecFunction &target = enterCall(ip->a, callee, cs);
+                if constexpr (Counted) ++cs.counters.calls;
+                double res = target.memo ? callMemoized(target, callee, cs)
+                           : target.native ? target.native(callee) : runSwitch<Counted>(target, callee, cs);
+                --cs.depth;
+                LOAD(ip->dst) = res;
+                break;
+            }
+            case ExecOp::CALLV: {
+                double *callee = frame + fn.numRegs;
+                const uint32_t *args = fn.argOperands.data() + ip->c;
+                for (uint32_t i = 0; i < ip->b; ++i) callee[i] = LOAD(args[i]);
+                const ExecFunction &target = enterCall(ip->a, callee, cs);
+                if constexpr (Counted) ++cs.counters.calls;
+                double res = target.memo ? callMemoized(target, callee, cs)
+                           : target.native ? target.native(callee) : runSwitch<Counted>(target, callee, cs);
+                --cs.depth;
+                LOAD(ip->dst) = res;
+                break;
+            }
+            case ExecOp::RET: return LOAD(ip->a);
+            case ExecOp::PRINT: printResult(cs, LOAD(ip->a)); break;
+            case ExecOp::END:
+            case ExecOp::COUNT:
+                return 0.0;
+        }
+    }
+}
 
-    if (!fir.params.empty() && static_cast<int>(fir.params.size()) != static_cast<int>(args.size())) {
-        std::cerr << "Aviso: função '" << name << "' esperava " << fir.params.size()
-                  << " args, recebeu " << args.size() << ".\n";
+double Interpreter::runThreaded(const ExecFunction *fn, double *frame, CallStack &cs) {
+#if MC_COMPUTED_GOTO
+    static const void *const handlers[] = {
+        &&op_mov,
+        &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_pow,
+        &&op_ret_add, &&op_ret_sub, &&op_ret_mul, &&op_ret_div, &&op_ret_pow,
+        &&op_neg,
+        &&op_arg,
+        &&op_call,
+        &&op_callv,
+        &&op_ret,
+        &&op_print,
+        &&op_end
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(ExecOp::COUNT),
+                  "tabela de handlers fora de sincronia com ExecOp");
+
+    if (!fn) {
+        threadedHandlers = handlers;
+        return 0.0;
     }
 
-    std::unordered_map<std::string, double> newScope;
+    double *const bases[3] = {frame, globals.data(), program.constants.data()};
+    const ExecInstr *ip = fn->code.data();
+
+#define NEXT() goto *(++ip)->handler
+
+    goto *ip->handler;
+
+op_mov: LOAD(ip->dst) = LOAD(ip->a); NEXT();
+op_add: LOAD(ip->dst) = LOAD(ip->a) + LOAD(ip->b); NEXT();
+op_sub: LOAD(ip->dst) = LOAD(ip->a) - LOAD(ip->b); NEXT();
+op_mul: LOAD(ip->dst) = LOAD(ip->a) * LOAD(ip->b); NEXT();
+op_div: LOAD(ip->dst) = divide(LOAD(ip->a), LOAD(ip->b)); NEXT();
+op_pow: LOAD(ip->dst) = std::pow(LOAD(ip->a), LOAD(ip->b)); NEXT();
+op_ret_add: return LOAD(ip->a) + LOAD(ip->b);
+op_ret_sub: return LOAD(ip->a) - LOAD(ip->b);
+op_ret_mul: return LOAD(ip->a) * LOAD(ip->b);
+op_ret_div: return divide(LOAD(ip->a), LOAD(ip->b));
+op_ret_pow: return std::pow(LOAD(ip->a), LOAD(ip->b));
+op_neg: LOAD(ip->dst) = -LOAD(ip->a); NEXT();
+op_arg: frame[fn->numRegs + ip->dst] = LOAD(ip->a); NEXT();
+op_call: {
+        double *callee = frame + fn->numRegs;
+        const ExecFunction &target = enterCall(ip->a, callee, cs);
+        double res = target.memo ? callMemoized(target, callee, cs)
+                   : target.native ? target.native(callee) : runThreaded(&target, callee, cs);
+        --cs.depth;
+        LOAD(ip->dst) = res;
+    }
+    NEXT();
+op_callv: {
+        double *callee = frame + fn->numRegs;
+        const uint32_t *args = fn->argOperands.data() + ip->c;
+        for (uint32_t i = 0; i < ip->b; ++i) callee[i] = LOAD(args[i]);
+        const ExecFunction &target = enterCall(ip->a, callee, cs);
+        double res = target.memo ? callMemoized(target, callee, cs)
+                   : target.native ? target.native(callee) : runThreaded(&target, callee, cs);
+        --cs.depth;
+        LOAD(ip->dst) = res;
+    }
+    NEXT();
+op_ret: return LOAD(ip->a);
+op_print: printResult(cs, LOAD(ip->a)); NEXT();
+op_end: return 0.0;
+
+#undef NEXT
+#else
+    return fn ? runSwitch<false>(*fn, frame, cs) : 0.0;
+#endif
+}
 
-    int limit = std::min(static_cast<int>(fir.params.size()), static_cast<int>(args.size()));
-    for (int i = 0; i < limit; ++i) {
-        newScope[fir.params[i]] = args[i];
+double Interpreter::run(const ExecFunction &fn, double *frame, CallStack &cs) {
+    switch (dispatch) {
+        case DispatchMode::THREADED: return runThreaded(&fn, frame, cs);
+        case DispatchMode::COUNTED: return runSwitch<true>(fn, frame, cs);
+        default: return runSwitch<false>(fn, frame, cs);
     }
+}
 
-    callStack.push_back(newScope);
+#undef LOAD
 
-    auto retPair = executeLines(fir.body);
+// Parâmetros nunca são escritos pelo corpo da função, então o frame ainda
+// contém os argumentos depois da execução e serve de chave para inserir.
+double Interpreter::callMemoized(const ExecFunction &target, double *frame, CallStack &cs) {
+    double value;
+    if (target.memo->lookup(frame, value)) return value;
 
-    callStack.pop_back();
+    value = target.native ? target.native(frame) : run(target, frame, cs);
 
-    if (retPair.first) {
-        return retPair.second;
-    } else {
-        
-        return 0.0;
+    target.memo->insert(frame, value);
+    return value;
+}
+
+void Interpreter::checkFrame(const std::string &name, uint32_t numRegs, double *frame,
+                             const CallStack &cs) const {
+    if (cs.depth >= MAX_CALL_DEPTH || frame + numRegs > cs.end) {
+        throw std::runtime_error("estouro da pilha de execução ao chamar '" + name + "'");
     }
 }
 
-void Interpreter::executeInstruction(const std::string& line) {
-    
-    std::string l = trim(line);
-    if (l.empty()) return;
-    
-    std::vector<std::string> tmp{l};
-    executeLines(tmp);
+// A análise semântica garante que a função existe e recebe o número certo de
+// argumentos.
+double Interpreter::callFunction(uint32_t index, uint32_t argc, double *frame) {
+    assert(index < program.functions.size());
+    const FunctionCode &fn = program.functions[index];
+    assert(fn.params.size() == argc);
+    (void)argc;
+
+    const ExecFunction &target = exec[index];
+    checkFrame(fn.name, target.frameNeed, frame, mainStack);
+
+    ++mainStack.depth;
+    ++mainStack.counters.calls;
+    double res;
+    if (trace) {
+        if (target.memo && target.memo->lookup(frame, res)) {
+            Trace::out() << "  " << fn.name << ": resultado em cache\n";
+        } else {
+            res = runTraced(fn, frame);
+            if (target.memo) target.memo->insert(frame, res);
+        }
+    }
+    else if (target.memo) res = callMemoized(target, frame, mainStack);
+    else if (target.native) res = target.native(frame);
+    else res = run(target, frame, mainStack);
+    --mainStack.depth;
+    return res;
 }
 
-void Interpreter::execute() {
-    std::cout << "\n=== EXECUÇÃO DO CÓDIGO ===\n";
+void Interpreter::runProgram() {
+    if (stack.get() + program.main.numRegs > mainStack.end) {
+        throw std::runtime_error("estouro da pilha de execução no programa principal");
+    }
+
+    mainStack.depth = 0;
+    if (trace) runTraced(program.main, stack.get());
+    else if (!unitCode.empty() && memos.empty()) runParallel();
+    else run(execMain, stack.get(), mainStack);
+}
 
-    for (const auto &line : mainLines) {
-        if (line.empty() || line.find("===") != std::string::npos) continue;
-        std::cout << "Executando: " << line << std::endl;
+void Interpreter::setSchedule(StatementGraph graph, size_t threads) {
+    schedule = std::move(graph);
+    scheduleThreads = threads;
+    unitCode.assign(schedule.units.size(), ExecFunction());
+
+    FunctionCode slice;
+    slice.numRegs = program.main.numRegs;
+    for (size_t u = 0; u < schedule.units.size(); ++u) {
+        const MainUnit &unit = schedule.units[u];
+        slice.code.assign(schedule.code.begin() + unit.begin, schedule.code.begin() + unit.end);
+        decode(slice, unitCode[u]);
+        bindHandlers(unitCode[u]);
+    }
+}
 
-        if (startsWith(line, "func_") || startsWith(line, "end_") || startsWith(line, "param ")) {
-            continue;
+// Cada unidade vira uma tarefa do pool, submetida quando as unidades de que
+// depende terminam. Um worker roda as suas numa pilha própria, e os valores
+// de PRINT ficam guardados por unidade: no fim são mostrados na ordem do
+// programa. Se uma unidade falha, as seguintes a ela não rodam e o erro é
+// relançado depois da saída das anteriores, como na execução em série.
+void Interpreter::runParallel() {
+    const auto &units = schedule.units;
+    uint32_t count = static_cast<uint32_t>(units.size());
+
+    std::vector<std::vector<uint32_t>> successors(count);
+    std::unique_ptr<std::atomic<uint32_t>[]> waiting(new std::atomic<uint32_t>[count]);
+    for (uint32_t u = 0; u < count; ++u) {
+        waiting[u].store(static_cast<uint32_t>(units[u].deps.size()));
+        for (uint32_t dep : units[u].deps) successors[dep].push_back(u);
+    }
+
+    std::vector<std::vector<double>> printed(count);
+    std::vector<std::exception_ptr> failures(count);
+    std::atomic<uint32_t> failedAt(count);
+    std::atomic<uint64_t> instructions(0), calls(0);
+
+    ThreadPool pool(scheduleThreads);
+    size_t slots = DEFAULT_STACK_SLOTS + program.main.numRegs + reservedArgs;
+    std::vector<std::unique_ptr<double[]>> stacks(pool.size());
+
+    std::function<void(uint32_t)> runUnit = [&](uint32_t u) {
+        if (u < failedAt.load()) {
+            auto &base = stacks[pool.currentWorker()];
+            if (!base) base.reset(new double[slots]);
+            CallStack cs{base.get() + slots - reservedArgs, 0, &printed[u], {}};
+            try {
+                run(unitCode[u], base.get(), cs);
+            } catch (...) {
+                failures[u] = std::current_exception();
+                uint32_t current = failedAt.load();
+                while (u < current && !failedAt.compare_exchange_weak(current, u)) {}
+            }
+            instructions.fetch_add(cs.counters.instructions, std::memory_order_relaxed);
+            calls.fetch_add(cs.counters.calls, std::memory_order_relaxed);
+        }
+        for (uint32_t next : successors[u]) {
+            if (waiting[next].fetch_sub(1) == 1) pool.submit([&runUnit, next] { runUnit(next); });
         }
+    };
 
-        std::vector<std::string> single{line};
-        executeLines(single);
+    for (uint32_t u = 0; u < count; ++u) {
+        if (units[u].deps.empty()) pool.submit([&runUnit, u] { runUnit(u); });
     }
+    pool.wait();
+    mainStack.counters.instructions += instructions.load();
+    mainStack.counters.calls += calls.load();
 
-    printVariables();
+    for (uint32_t u = 0; u < count; ++u) {
+        for (double value : printed[u]) printResult(value);
+        if (failures[u]) std::rethrow_exception(failures[u]);
+    }
+}
+
+void Interpreter::execute() {
+    if (trace || Trace::enabled(Trace::SUMMARY)) Trace::out() << "\n=== EXECUÇÃO DO CÓDIGO ===\n";
+
+    runProgram();
+
+    if (Trace::enabled(Trace::SUMMARY)) printVariables();
 }
 
 void Interpreter::printVariables() const {
-    std::cout << "\n=== VARIÁVEIS FINAIS ===\n";
-    if (!callStack.empty()) {
-        std::unordered_map<std::string, double> merged;
-        for (const auto &scope : callStack) {
-            for (const auto &kv : scope) merged[kv.first] = kv.second;
-        }
+    Trace::out() << "\n=== VARIÁVEIS FINAIS ===\n";
+    if (globals.empty()) {
+        Trace::out() << "(nenhuma variável)\n";
+        return;
+    }
 
-        for (const auto &kv : merged) {
-            if (!kv.first.empty() && kv.first[0] == 't') continue; 
-            std::cout << kv.first << " = " << kv.second << std::endl;
-        }
-    } else {
-        std::cout << "(nenhuma variável)\n";
+    for (size_t i = 0; i < globals.size(); ++i) {
+        Trace::out() << program.globals[i] << " = " << globals[i] << '\n';
+    }
+}
+
+void Interpreter::syncData(const Program &source) {
+    for (size_t i = program.constants.size(); i < source.constants.size(); ++i) {
+        program.constants.push_back(source.constants[i]);
+    }
+    for (size_t i = program.globals.size(); i < source.globals.size(); ++i) {
+        program.globals.push_back(source.globals[i]);
+    }
+    globals.resize(program.globals.size(), 0.0);
+}
+
+void Interpreter::setFunction(uint32_t index, const FunctionCode &fn) {
+    if (index >= program.functions.size()) {
+        program.functions.resize(index + 1);
+        exec.resize(index + 1);
+    }
+    program.functions[index] = fn;
+    reserveArgs(fn);
+    exec[index] = ExecFunction();
+    decode(program.functions[index], exec[index]);
+    bindHandlers(exec[index]);
+}
+
+void Interpreter::runStatement(const FunctionCode &code) {
+    program.main = code;
+    reserveArgs(program.main);
+    execMain = ExecFunction();
+    decode(program.main, execMain);
+    bindHandlers(execMain);
+    runProgram();
+}
+
+void Interpreter::printMemoStats() const {
+    if (memos.empty() || !Trace::enabled(Trace::SUMMARY)) return;
+
+    Trace::out() << "\n=== CACHE DE CHAMADAS ===\n";
+    for (size_t i = 0; i < memos.size(); ++i) {
+        if (!memos[i]) continue;
+        const MemoStats &st = memos[i]->getStats();
+        if (st.hits == 0 && st.misses == 0) continue;
+        Trace::out() << program.functions[i].name << ": " << st.hits << " acertos, "
+                  << st.misses << " falhas, " << st.evictions << " substituições, "
+                  << memos[i]->size() << " entradas\n";
     }
 }
@@ -0,0 +1,353 @@
+#include "../include/ir_optimizer.h"
+#include <functional>
+#include <map>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+IrOptimizer::IrOptimizer() {}
+
+static bool isTemp(const FunctionCode &fn, uint32_t operand) {
+    return operandKind(operand) == OperandKind::REG && operandIndex(operand) >= fn.params.size();
+}
+
+// Operandos lidos diretamente por uma instrução; os de CALL (argumentos e
+// globais consultadas pelo corpo) são tratados à parte.
+static size_t readOperands(const Instruction &ins, uint32_t out[2]) {
+    switch (ins.op) {
+        case OpCode::MOV: case OpCode::NEG: case OpCode::ARG:
+        case OpCode::RET: case OpCode::PRINT:
+            out[0] = ins.a;
+            return 1;
+        case OpCode::CALL:
+            return 0;
+        default:
+            out[0] = ins.a;
+            out[1] = ins.b;
+            return 2;
+    }
+}
+
+static bool writesDst(const Instruction &ins) {
+    return ins.op != OpCode::ARG && ins.op != OpCode::RET && ins.op != OpCode::PRINT;
+}
+
+void IrOptimizer::optimize(Program &program) {
+    stats = IrStats();
+    size_t globalCount = program.globals.size();
+    readsGlobals = functionsReadingGlobals(program);
+
+    for (auto &fn : program.functions) {
+        valueNumbering(fn);
+        eliminateDeadCode(fn, globalCount, false);
+        allocateRegisters(fn);
+    }
+    valueNumbering(program.main);
+    eliminateDeadCode(program.main, globalCount, true);
+    allocateRegisters(program.main);
+}
+
+static bool isCommutative(OpCode op) {
+    return op == OpCode::ADD || op == OpCode::MUL;
+}
+
+// Numeração de valores: cada operando recebe o número do valor que contém e
+// cada expressão (op, números dos operandos) é registrada. Uma expressão já
+// vista é trocada pelo seu "líder", um operando que guarda o valor e nunca é
+// sobrescrito (constante, parâmetro ou temporário escrito uma única vez).
+// Chamadas contam como expressões porque todas as funções são puras; a de
+// uma função que lê globais leva na chave quantas escritas em globais já
+// houve, para não reaproveitar um resultado calculado com valores antigos.
+void IrOptimizer::valueNumbering(FunctionCode &fn) {
+    std::vector<uint32_t> writes(fn.numRegs, 0);
+    for (const auto &ins : fn.code) {
+        if (writesDst(ins) && operandKind(ins.dst) == OperandKind::REG) {
+            ++writes[operandIndex(ins.dst)];
+        }
+    }
+
+    auto singleDef = [&](uint32_t operand) {
+        return operandKind(operand) == OperandKind::REG &&
+               operandIndex(operand) >= fn.params.size() &&
+               writes[operandIndex(operand)] == 1;
+    };
+    auto canLead = [&](uint32_t operand) {
+        switch (operandKind(operand)) {
+            case OperandKind::CONST: return true;
+            case OperandKind::REG:
+                return operandIndex(operand) < fn.params.size() || singleDef(operand);
+            default: return false;
+        }
+    };
+
+    std::unordered_map<uint32_t, uint32_t> valueOf;
+    std::vector<uint32_t> leader;
+    std::map<std::vector<uint32_t>, uint32_t> expressions;
+
+    auto newValue = [&](uint32_t holder) {
+        leader.push_back(canLead(holder) ? holder : NO_OPERAND);
+        return static_cast<uint32_t>(leader.size() - 1);
+    };
+    auto valueNumber = [&](uint32_t operand) {
+        auto it = valueOf.find(operand);
+        if (it != valueOf.end()) return it->second;
+        uint32_t vn = newValue(operand);
+        valueOf[operand] = vn;
+        return vn;
+    };
+    auto rewrite = [&](uint32_t operand) {
+        uint32_t lead = leader[valueNumber(operand)];
+        return lead != NO_OPERAND ? lead : operand;
+    };
+    auto define = [&](uint32_t dst, uint32_t vn) {
+        valueOf[dst] = vn;
+        if (leader[vn] == NO_OPERAND && canLead(dst)) leader[vn] = dst;
+    };
+
+    std::vector<Instruction> out;
+    out.reserve(fn.code.size());
+    std::vector<uint32_t> pendingArgs;
+    size_t firstArg = 0;
+    uint32_t globalStores = 0;
+
+    // Devolve true se a instrução que define dst com a chave dada é redundante.
+    auto lookup = [&](std::vector<uint32_t> key, uint32_t dst, bool &reuse, uint32_t &lead) {
+        auto it = expressions.find(key);
+        if (it != expressions.end() && leader[it->second] != NO_OPERAND) {
+            lead = leader[it->second];
+            reuse = true;
+            if (singleDef(dst)) {
+                valueOf[dst] = it->second;
+                return true;
+            }
+            define(dst, it->second);
+            return false;
+        }
+        reuse = false;
+        uint32_t vn = newValue(dst);
+        expressions[key] = vn;
+        valueOf[dst] = vn;
+        return false;
+    };
+
+    for (Instruction ins : fn.code) {
+        bool storesGlobal = writesDst(ins) && operandKind(ins.dst) == OperandKind::GLOBAL;
+        switch (ins.op) {
+            case OpCode::MOV:
+                ins.a = rewrite(ins.a);
+                out.push_back(ins);
+                define(ins.dst, valueNumber(ins.a));
+                break;
+            case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+            case OpCode::DIV: case OpCode::POW: case OpCode::NEG: {
+                ins.a = rewrite(ins.a);
+                uint32_t va = valueNumber(ins.a);
+                uint32_t vb = 0;
+                if (ins.op != OpCode::NEG) {
+                    ins.b = rewrite(ins.b);
+                    vb = valueNumber(ins.b);
+                    if (isCommutative(ins.op) && vb < va) std::swap(va, vb);
+                }
+
+                bool reuse;
+                uint32_t lead;
+                if (lookup({static_cast<uint32_t>(ins.op), va, vb}, ins.dst, reuse, lead)) {
+                    ++stats.redundant;
+                } else if (reuse) {
+                    out.push_back({OpCode::MOV, ins.dst, lead, 0});
+                    ++stats.redundant;
+                } else {
+                    out.push_back(ins);
+                }
+                break;
+            }
+            case OpCode::ARG:
+                ins.a = rewrite(ins.a);
+                if (pendingArgs.empty()) firstArg = out.size();
+                pendingArgs.push_back(valueNumber(ins.a));
+                out.push_back(ins);
+                break;
+            case OpCode::CALL: {
+                std::vector<uint32_t> key{static_cast<uint32_t>(OpCode::CALL), ins.a, ins.b};
+                key.insert(key.end(), pendingArgs.begin(), pendingArgs.end());
+                if (readsGlobals[ins.a]) key.push_back(globalStores);
+
+                bool reuse;
+                uint32_t lead;
+                bool argsBeforeCall = pendingArgs.size() == ins.b &&
+                                      firstArg + pendingArgs.size() == out.size();
+                if (argsBeforeCall && lookup(key, ins.dst, reuse, lead)) {
+                    out.resize(firstArg);
+                    ++stats.redundant;
+                } else if (argsBeforeCall && reuse) {
+                    out.resize(firstArg);
+                    out.push_back({OpCode::MOV, ins.dst, lead, 0});
+                    ++stats.redundant;
+                } else {
+                    if (!argsBeforeCall) define(ins.dst, newValue(ins.dst));
+                    out.push_back(ins);
+                }
+                pendingArgs.clear();
+                break;
+            }
+            case OpCode::RET: case OpCode::PRINT:
+                ins.a = rewrite(ins.a);
+                out.push_back(ins);
+                break;
+        }
+        if (storesGlobal) ++globalStores;
+    }
+
+    fn.code = std::move(out);
+}
+
+// Eliminação de código morto por vivacidade, de trás para frente: uma
+// instrução cujo destino não é lido depois (nem observado no fim, no caso das
+// globais do programa principal) é removida. Os slots de argumento contam como
+// posições próprias, de modo que uma chamada removida leva junto os seus ARG.
+void IrOptimizer::eliminateDeadCode(FunctionCode &fn, size_t globalCount, bool topLevel) {
+    uint32_t maxArgs = 0;
+    for (const auto &ins : fn.code) {
+        if (ins.op == OpCode::CALL && ins.b > maxArgs) maxArgs = ins.b;
+    }
+
+    size_t globalBase = fn.numRegs;
+    size_t argBase = globalBase + globalCount;
+    std::vector<char> live(argBase + maxArgs, 0);
+
+    auto location = [&](uint32_t operand) -> size_t {
+        switch (operandKind(operand)) {
+            case OperandKind::REG: return operandIndex(operand);
+            case OperandKind::GLOBAL: return globalBase + operandIndex(operand);
+            default: return live.size();
+        }
+    };
+    auto use = [&](uint32_t operand) {
+        size_t loc = location(operand);
+        if (loc < live.size()) live[loc] = 1;
+    };
+    auto useGlobals = [&]() {
+        std::fill(live.begin() + globalBase, live.begin() + argBase, 1);
+    };
+
+    if (topLevel) useGlobals();
+
+    std::vector<char> keep(fn.code.size(), 1);
+    for (size_t i = fn.code.size(); i-- > 0;) {
+        const Instruction &ins = fn.code[i];
+        uint32_t reads[2];
+
+        switch (ins.op) {
+            case OpCode::RET: case OpCode::PRINT:
+                use(ins.a);
+                continue;
+            case OpCode::ARG: {
+                size_t loc = argBase + ins.dst;
+                if (!live[loc]) {
+                    keep[i] = 0;
+                    continue;
+                }
+                live[loc] = 0;
+                use(ins.a);
+                continue;
+            }
+            default:
+                break;
+        }
+
+        size_t loc = location(ins.dst);
+        bool selfMove = ins.op == OpCode::MOV && ins.a == ins.dst;
+        if (!live[loc] || selfMove) {
+            keep[i] = 0;
+            continue;
+        }
+        live[loc] = 0;
+
+        if (ins.op == OpCode::CALL) {
+            for (uint32_t k = 0; k < ins.b; ++k) live[argBase + k] = 1;
+            if (readsGlobals[ins.a]) useGlobals();
+            continue;
+        }
+        size_t count = readOperands(ins, reads);
+        for (size_t k = 0; k < count; ++k) use(reads[k]);
+    }
+
+    std::vector<Instruction> out;
+    out.reserve(fn.code.size());
+    for (size_t i = 0; i < fn.code.size(); ++i) {
+        if (keep[i]) out.push_back(fn.code[i]);
+        else ++stats.dead;
+    }
+    fn.code = std::move(out);
+}
+
+// Reuso de temporários: cada temporário recebe um registrador físico quando é
+// definido e o devolve após a última leitura, sempre escolhendo o menor livre.
+// O frame passa a ter parâmetros + máximo de temporários vivos ao mesmo tempo.
+void IrOptimizer::allocateRegisters(FunctionCode &fn) {
+    size_t n = fn.code.size();
+    std::vector<char> live(fn.numRegs, 0);
+    std::vector<uint8_t> dies(n, 0);   // bit k: a leitura k é a última do valor
+
+    for (size_t i = n; i-- > 0;) {
+        const Instruction &ins = fn.code[i];
+        if (writesDst(ins) && isTemp(fn, ins.dst)) live[operandIndex(ins.dst)] = 0;
+
+        uint32_t reads[2];
+        size_t count = readOperands(ins, reads);
+        for (size_t k = 0; k < count; ++k) {
+            if (!isTemp(fn, reads[k])) continue;
+            uint32_t reg = operandIndex(reads[k]);
+            if (!live[reg]) dies[i] |= static_cast<uint8_t>(1u << k);
+            live[reg] = 1;
+        }
+    }
+
+    uint32_t params = static_cast<uint32_t>(fn.params.size());
+    uint32_t nextReg = params;
+    std::vector<uint32_t> physical(fn.numRegs, NO_OPERAND);
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> freeRegs;
+
+    auto translate = [&](uint32_t &operand) {
+        if (isTemp(fn, operand) && physical[operandIndex(operand)] != NO_OPERAND) {
+            operand = makeOperand(OperandKind::REG, physical[operandIndex(operand)]);
+        }
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        Instruction &ins = fn.code[i];
+        uint32_t reads[2] = {0, 0};
+        size_t count = readOperands(ins, reads);
+
+        // Operandos são lidos antes de o destino ser escrito, então um
+        // registrador liberado aqui já pode receber o resultado da instrução.
+        uint32_t translated[2] = {reads[0], reads[1]};
+        for (size_t k = 0; k < count; ++k) translate(translated[k]);
+        for (size_t k = 0; k < count; ++k) {
+            uint32_t reg = operandIndex(reads[k]);
+            if ((dies[i] & (1u << k)) && physical[reg] != NO_OPERAND) {
+                freeRegs.push(physical[reg]);
+                physical[reg] = NO_OPERAND;
+            }
+        }
+        if (count > 0) ins.a = translated[0];
+        if (count > 1) ins.b = translated[1];
+
+        if (writesDst(ins) && isTemp(fn, ins.dst)) {
+            uint32_t reg = operandIndex(ins.dst);
+            if (physical[reg] == NO_OPERAND) {
+                if (!freeRegs.empty()) {
+                    physical[reg] = freeRegs.top();
+                    freeRegs.pop();
+                } else {
+                    physical[reg] = nextReg++;
+                }
+            }
+            ins.dst = makeOperand(OperandKind::REG, physical[reg]);
+        }
+    }
+
+    stats.registersBefore += fn.numRegs;
+    fn.numRegs = nextReg;
+    stats.registersAfter += fn.numRegs;
+}
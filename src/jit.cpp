@@ -0,0 +1,335 @@
+#include "../include/jit.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if MC_JIT_AVAILABLE
+#include <sys/mman.h>
+#endif
+
+JitCompiler::JitCompiler() : memory(nullptr), memorySize(0) {}
+
+JitCompiler::~JitCompiler() {
+#if MC_JIT_AVAILABLE
+    if (memory) munmap(memory, memorySize);
+#endif
+}
+
+NativeFunction JitCompiler::entry(uint32_t index) const {
+    return index < entries.size() ? entries[index] : nullptr;
+}
+
+uint32_t JitCompiler::stackNeed(uint32_t index) const {
+    return index < stackNeeds.size() ? stackNeeds[index] : 0;
+}
+
+// Só compila funções cujo grafo de chamadas alcançável não tem ciclos: assim
+// o código nativo nunca recursa e nunca precisa voltar ao interpretador.
+std::vector<bool> JitCompiler::selectFunctions(const Program &program) const {
+    enum State : uint8_t { UNVISITED, VISITING, OK, REJECTED };
+    std::vector<State> state(program.functions.size(), UNVISITED);
+
+    auto visit = [&](auto &self, uint32_t index) -> bool {
+        if (state[index] == VISITING || state[index] == REJECTED) return false;
+        if (state[index] == OK) return true;
+
+        state[index] = VISITING;
+        bool ok = true;
+        for (const auto &ins : program.functions[index].code) {
+            if (ins.op == OpCode::CALL && !self(self, ins.a)) ok = false;
+        }
+        state[index] = ok ? OK : REJECTED;
+        return ok;
+    };
+
+    std::vector<bool> selected(program.functions.size());
+    for (uint32_t i = 0; i < program.functions.size(); ++i) {
+        selected[i] = visit(visit, i);
+    }
+    return selected;
+}
+
+#if MC_JIT_AVAILABLE
+
+namespace {
+
+class Assembler {
+public:
+    std::vector<uint8_t> code;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void bytes(std::initializer_list<uint8_t> bs) { code.insert(code.end(), bs); }
+
+    void u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void u64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) byte(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void patch32(size_t at, uint32_t v) {
+        for (int i = 0; i < 4; ++i) code[at + i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    size_t size() const { return code.size(); }
+};
+
+struct CallFixup {
+    size_t at;
+    uint32_t target;
+};
+
+class FunctionEmitter {
+private:
+    Assembler &as;
+    double *globals;
+    size_t constantsOffset;
+    size_t nanOffset;
+    size_t signOffset;
+
+    // movsd xmm, [rip + disp32] apontando para uma constante do início do buffer
+    void loadRipRelative(int xmm, size_t target) {
+        as.bytes({0xF2, 0x0F, 0x10, static_cast<uint8_t>((xmm << 3) | 0x05)});
+        size_t next = as.size() + 4;
+        as.u32(static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(next)));
+    }
+
+    void movRaxImm(const void *ptr) {
+        as.bytes({0x48, 0xB8});
+        as.u64(reinterpret_cast<uint64_t>(ptr));
+    }
+
+public:
+    FunctionEmitter(Assembler &a, double *g, size_t constOff, size_t nanOff, size_t signOff)
+        : as(a), globals(g), constantsOffset(constOff), nanOffset(nanOff), signOffset(signOff) {}
+
+    void load(int xmm, uint32_t operand) {
+        uint32_t index = operandIndex(operand);
+        switch (operandKind(operand)) {
+            case OperandKind::REG:
+                as.bytes({0xF2, 0x0F, 0x10, static_cast<uint8_t>(0x80 | (xmm << 3) | 0x03)});
+                as.u32(index * 8);
+                break;
+            case OperandKind::CONST:
+                loadRipRelative(xmm, constantsOffset + index * 8);
+                break;
+            case OperandKind::GLOBAL:
+                movRaxImm(globals + index);
+                as.bytes({0xF2, 0x0F, 0x10, static_cast<uint8_t>(xmm << 3)});
+                break;
+        }
+    }
+
+    void store(int xmm, uint32_t operand) {
+        uint32_t index = operandIndex(operand);
+        if (operandKind(operand) == OperandKind::GLOBAL) {
+            movRaxImm(globals + index);
+            as.bytes({0xF2, 0x0F, 0x11, static_cast<uint8_t>(xmm << 3)});
+            return;
+        }
+        as.bytes({0xF2, 0x0F, 0x11, static_cast<uint8_t>(0x80 | (xmm << 3) | 0x03)});
+        as.u32(index * 8);
+    }
+
+    void storeFrame(int xmm, uint32_t slot) {
+        as.bytes({0xF2, 0x0F, 0x11, static_cast<uint8_t>(0x80 | (xmm << 3) | 0x03)});
+        as.u32(slot * 8);
+    }
+
+    void prologue() {
+        as.byte(0x53);                    // push rbx
+        as.bytes({0x48, 0x89, 0xFB});     // mov rbx, rdi
+    }
+
+    void epilogue() {
+        as.byte(0x5B);                    // pop rbx
+        as.byte(0xC3);                    // ret
+    }
+
+    void arithmetic(OpCode op) {
+        switch (op) {
+            case OpCode::ADD: as.bytes({0xF2, 0x0F, 0x58, 0xC1}); break;   // addsd xmm0, xmm1
+            case OpCode::SUB: as.bytes({0xF2, 0x0F, 0x5C, 0xC1}); break;   // subsd xmm0, xmm1
+            case OpCode::MUL: as.bytes({0xF2, 0x0F, 0x59, 0xC1}); break;   // mulsd xmm0, xmm1
+            case OpCode::DIV:
+                // divisor zero produz NaN, como no interpretador
+                as.bytes({0x66, 0x0F, 0x57, 0xD2});   // xorpd xmm2, xmm2
+                as.bytes({0x66, 0x0F, 0x2E, 0xCA});   // ucomisd xmm1, xmm2
+                as.bytes({0x75, 0x0C});               // jne div
+                as.bytes({0x7A, 0x0A});               // jp div
+                loadRipRelative(0, nanOffset);        // movsd xmm0, [nan]
+                as.bytes({0xEB, 0x04});               // jmp done
+                as.bytes({0xF2, 0x0F, 0x5E, 0xC1});   // div: divsd xmm0, xmm1
+                break;
+            case OpCode::POW: {
+                double (*powFn)(double, double) = std::pow;
+                movRaxImm(reinterpret_cast<const void *>(powFn));
+                as.bytes({0xFF, 0xD0});               // call rax
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void negate() {
+        as.bytes({0x66, 0x0F, 0x57, 0x05});   // xorpd xmm0, [rip + sinal]
+        size_t next = as.size() + 4;
+        as.u32(static_cast<uint32_t>(static_cast<int64_t>(signOffset) - static_cast<int64_t>(next)));
+    }
+
+    void call(uint32_t frameOffset, uint32_t target, std::vector<CallFixup> &fixups) {
+        as.bytes({0x48, 0x8D, 0xBB});     // lea rdi, [rbx + disp32]
+        as.u32(frameOffset * 8);
+        as.byte(0xE8);                    // call rel32
+        fixups.push_back({as.size(), target});
+        as.u32(0);
+    }
+};
+
+}
+
+size_t JitCompiler::compile(const Program &program, double *globals) {
+    std::vector<bool> selected = selectFunctions(program);
+    size_t count = program.functions.size();
+
+    entries.assign(count, nullptr);
+    stackNeeds.assign(count, 0);
+
+    Assembler as;
+    // máscara do bit de sinal primeiro, alinhada em 16 bytes para o xorpd
+    size_t signOffset = 0;
+    as.u64(0x8000000000000000ull);
+    as.u64(0);
+    size_t constantsOffset = as.size();
+    for (double c : program.constants) {
+        uint64_t bits;
+        std::memcpy(&bits, &c, sizeof(bits));
+        as.u64(bits);
+    }
+    size_t nanOffset = as.size();
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    uint64_t nanBits;
+    std::memcpy(&nanBits, &nan, sizeof(nanBits));
+    as.u64(nanBits);
+
+    std::vector<size_t> offsets(count, 0);
+    std::vector<CallFixup> fixups;
+    size_t compiled = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!selected[i]) continue;
+        const FunctionCode &fn = program.functions[i];
+
+        while (as.size() % 16 != 0) as.byte(0xCC);
+        offsets[i] = as.size();
+
+        FunctionEmitter em(as, globals, constantsOffset, nanOffset, signOffset);
+        em.prologue();
+
+        bool returned = false;
+        for (const auto &ins : fn.code) {
+            switch (ins.op) {
+                case OpCode::MOV:
+                    em.load(0, ins.a);
+                    em.store(0, ins.dst);
+                    break;
+                case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+                case OpCode::DIV: case OpCode::POW:
+                    em.load(0, ins.a);
+                    em.load(1, ins.b);
+                    em.arithmetic(ins.op);
+                    em.store(0, ins.dst);
+                    break;
+                case OpCode::NEG:
+                    em.load(0, ins.a);
+                    em.negate();
+                    em.store(0, ins.dst);
+                    break;
+                case OpCode::ARG:
+                    em.load(0, ins.a);
+                    em.storeFrame(0, fn.numRegs + ins.dst);
+                    break;
+                case OpCode::CALL:
+                    em.call(fn.numRegs, ins.a, fixups);
+                    em.store(0, ins.dst);
+                    break;
+                case OpCode::RET:
+                    em.load(0, ins.a);
+                    em.epilogue();
+                    returned = true;
+                    break;
+                case OpCode::PRINT:
+                    // só aparece no programa principal, que não é compilado
+                    break;
+            }
+            if (returned) break;
+        }
+
+        if (!returned) {
+            as.bytes({0x66, 0x0F, 0x57, 0xC0});   // xorpd xmm0, xmm0
+            em.epilogue();
+        }
+        ++compiled;
+    }
+
+    if (compiled == 0) return 0;
+
+    for (const auto &fix : fixups) {
+        int64_t rel = static_cast<int64_t>(offsets[fix.target]) - static_cast<int64_t>(fix.at + 4);
+        as.patch32(fix.at, static_cast<uint32_t>(rel));
+    }
+
+    void *mem = mmap(nullptr, as.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        throw std::runtime_error("JIT: falha ao alocar memória executável");
+    }
+    std::memcpy(mem, as.code.data(), as.size());
+    if (mprotect(mem, as.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, as.size());
+        throw std::runtime_error("JIT: falha ao proteger memória executável");
+    }
+
+    if (memory) munmap(memory, memorySize);
+    memory = mem;
+    memorySize = as.size();
+
+    // Frames de funções nativas crescem sem checagem; o interpretador garante
+    // antes da chamada que cabe o pior caminho da árvore de chamadas.
+    std::vector<bool> done(count, false);
+    auto need = [&](auto &self, uint32_t index) -> uint32_t {
+        if (done[index]) return stackNeeds[index];
+        const FunctionCode &fn = program.functions[index];
+        uint32_t deepest = 0;
+        for (const auto &ins : fn.code) {
+            if (ins.op == OpCode::ARG && ins.dst + 1 > deepest) deepest = ins.dst + 1;
+            if (ins.op == OpCode::CALL) {
+                uint32_t callee = self(self, ins.a);
+                if (callee > deepest) deepest = callee;
+            }
+        }
+        done[index] = true;
+        stackNeeds[index] = fn.numRegs + deepest;
+        return stackNeeds[index];
+    };
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!selected[i]) continue;
+        entries[i] = reinterpret_cast<NativeFunction>(static_cast<uint8_t *>(memory) + offsets[i]);
+        need(need, i);
+    }
+
+    return compiled;
+}
+
+#else
+
+size_t JitCompiler::compile(const Program &program, double *) {
+    entries.assign(program.functions.size(), nullptr);
+    stackNeeds.assign(program.functions.size(), 0);
+    return 0;
+}
+
+#endif
@@ -1,100 +1,117 @@
 #include "../include/lexer.h"
-#include <cctype>
+#include <algorithm>
+#include <array>
 
-Lexer::Lexer(const std::string &src) : source(src), pos(0), line(1), column(1) {}
+namespace {
 
-char Lexer::peek() const {
-    return pos < source.size() ? source[pos] : '\0';
-}
+// Classe de cada byte, consultada numa tabela em vez de isalpha/isdigit.
+enum CharClass : uint8_t {
+    SPACE = 1 << 0,
+    ALPHA = 1 << 1,
+    DIGIT = 1 << 2,
+    UNDERSCORE = 1 << 3,
+    OPERATOR = 1 << 4,
+    PUNCT = 1 << 5,
+    IDENT = ALPHA | DIGIT | UNDERSCORE
+};
 
-char Lexer::get() {
-    char c = peek();
-    if (c == '\n') { line++; column = 1; }
-    else column++;
-    pos++;
-    return c;
+constexpr std::array<uint8_t, 256> makeClasses() {
+    std::array<uint8_t, 256> table{};
+    for (char c : std::string_view(" \t\n\v\f\r")) table[static_cast<uint8_t>(c)] = SPACE;
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = ALPHA;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = ALPHA;
+    for (int c = '0'; c <= '9'; ++c) table[c] = DIGIT;
+    table['_'] = UNDERSCORE;
+    for (char c : std::string_view("+-*/^")) table[static_cast<uint8_t>(c)] = OPERATOR;
+    for (char c : std::string_view("=(),")) table[static_cast<uint8_t>(c)] = PUNCT;
+    return table;
 }
 
-void Lexer::skipWhitespace() {
-    while (isspace((unsigned char)peek())) get();
+constexpr std::array<uint8_t, 256> CLASSES = makeClasses();
+
+inline bool is(char c, uint8_t mask) {
+    return (CLASSES[static_cast<uint8_t>(c)] & mask) != 0;
 }
 
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
+Operator operatorFor(char c) {
+    switch (c) {
+        case '+': return Operator::ADD;
+        case '-': return Operator::SUB;
+        case '*': return Operator::MUL;
+        case '/': return Operator::DIV;
+        default: return Operator::POW;
+    }
+}
 
-    while (pos < source.size()) {
-        skipWhitespace();
-        char c = peek();
-        if (c == '\0') break;
+TokenType punctuationType(char c) {
+    switch (c) {
+        case '=': return TokenType::ATRIB;
+        case '(': return TokenType::LPAREN;
+        case ')': return TokenType::RPAREN;
+        default: return TokenType::COMMA;
+    }
+}
 
-        int tokLine = line;
-        int tokCol = column;
+}
 
-        if (isalpha((unsigned char)c)) {
-            std::string id;
-            while (isalnum((unsigned char)peek()) || peek() == '_') id += get();
-            TokenType type = (id == "funcao") ? TokenType::FUNC : TokenType::ID;
-            tokens.push_back({type, id, tokLine, tokCol});
+SourceLocation LineIndex::locate(const char *at) const {
+    if (starts.empty()) {
+        starts.push_back(0);
+        for (size_t i = 0; i < source.size(); ++i) {
+            if (source[i] == '\n') starts.push_back(static_cast<uint32_t>(i + 1));
         }
-        else if (isdigit((unsigned char)c) || (c == '-' && isdigit(source[pos + 1]))) {
-            std::string num;
-            bool dotSeen = false;
-            bool isNegative = false;
-            
-            if (c == '-') {
-                isNegative = true;
-                num += get();
-            }
-            
-            while (isdigit((unsigned char)peek()) || (!dotSeen && peek() == '.')) {
-                if (peek() == '.') dotSeen = true;
-                num += get();
-            }
-            
-            if (isNegative && num.length() == 1) {
-                tokens.push_back({TokenType::OP_ARIT, "-", tokLine, tokCol});
-            } else {
-                tokens.push_back({TokenType::NUM, num, tokLine, tokCol});
-            }
-        }
-        else {
-            switch (c) {
-                case '+': case '*': case '/': case '^': {
-                    std::string s(1, get());
-                    tokens.push_back({TokenType::OP_ARIT, s, tokLine, tokCol});
-                    break;
-                }
-                case '-': {
-                    std::string s(1, get());
-                    tokens.push_back({TokenType::OP_ARIT, s, tokLine, tokCol});
-                    break;
-                }
-                case '=':
-                    get();
-                    tokens.push_back({TokenType::ATRIB, "=", tokLine, tokCol});
-                    break;
-                case '(':
-                    get();
-                    tokens.push_back({TokenType::LPAREN, "(", tokLine, tokCol});
-                    break;
-                case ')':
-                    get();
-                    tokens.push_back({TokenType::RPAREN, ")", tokLine, tokCol});
-                    break;
-                case ',':
-                    get();
-                    tokens.push_back({TokenType::COMMA, ",", tokLine, tokCol});
-                    break;
-                default:
-                    {
-                        std::string s(1, get());
-                        tokens.push_back({TokenType::INVALID, s, tokLine, tokCol});
-                    }
-                    break;
-            }
+    }
+    auto offset = static_cast<uint32_t>(at - source.data());
+    auto line = std::upper_bound(starts.begin(), starts.end(), offset) - 1;
+    return SourceLocation{static_cast<int>(line - starts.begin()) + 1,
+                          static_cast<int>(offset - *line) + 1};
+}
+
+Lexer::Lexer(std::string_view src) : source(src), cursor(src.data()), lines(src) {}
+
+Token Lexer::next() {
+    const char *p = cursor;
+    const char *end = source.data() + source.size();
+
+    while (p < end && is(*p, SPACE)) ++p;
+    // NUL encerra o código, como no fim do texto
+    if (p == end || *p == '\0') {
+        cursor = p;
+        return Token(TokenType::END_OF_FILE, std::string_view(p, 0));
+    }
+
+    const char *start = p;
+    char c = *p;
+    auto take = [&](TokenType type, Symbol symbol = Symbols::NONE, Operator op = Operator::NONE) {
+        cursor = p;
+        return Token(type, std::string_view(start, static_cast<size_t>(p - start)), symbol, op);
+    };
+
+    if (is(c, ALPHA)) {
+        while (++p < end && is(*p, IDENT)) {}
+        std::string_view id(start, static_cast<size_t>(p - start));
+        if (id == "funcao") return take(TokenType::FUNC);
+        return take(TokenType::ID, Symbols::intern(id));
+    }
+    if (is(c, DIGIT) || (c == '-' && p + 1 < end && is(p[1], DIGIT))) {
+        if (c == '-') ++p;
+        while (p < end && is(*p, DIGIT)) ++p;
+        if (p < end && *p == '.') {
+            ++p;
+            while (p < end && is(*p, DIGIT)) ++p;
         }
+        return take(TokenType::NUM);
     }
 
-    tokens.push_back({TokenType::END_OF_FILE, "", line, column});
+    ++p;
+    if (is(c, OPERATOR)) return take(TokenType::OP_ARIT, Symbols::NONE, operatorFor(c));
+    return take(is(c, PUNCT) ? punctuationType(c) : TokenType::INVALID);
+}
+
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    do {
+        tokens.push_back(next());
+    } while (tokens.back().type != TokenType::END_OF_FILE);
     return tokens;
-}
\ No newline at end of file
+}
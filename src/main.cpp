@@ -1,72 +1,466 @@
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/semantic.h"
+#include "../include/optimizer.h"
+#include "../include/inliner.h"
 #include "../include/codegen.h"
 #include "../include/interpreter.h"
+#include "../include/batch.h"
+#include "../include/stream.h"
+#include "../include/mapped_file.h"
+#include "../include/session.h"
+#include "../include/schedule.h"
+#include "../include/stats.h"
+#include "../include/thread_pool.h"
+#include "../include/trace.h"
 
-int main() {
-    std::cout << "Digite o código da linguagem (uma linha por vez, termine com linha vazia):\n";
-
-    std::stringstream buffer;
+// Lê as linhas de dados do modo lote: valores separados por vírgula, ponto e
+// vírgula ou espaço, uma linha por chamada, guardados por coluna.
+static std::vector<std::vector<double>> readColumns(std::istream &in) {
+    std::vector<std::vector<double>> columns;
     std::string linha;
+    size_t numero = 0;
+
+    while (std::getline(in, linha)) {
+        ++numero;
+        for (char &c : linha) {
+            if (c == ',' || c == ';') c = ' ';
+        }
+        std::istringstream campos(linha);
+        std::vector<double> valores;
+        std::string campo;
+        while (campos >> campo) {
+            try {
+                valores.push_back(std::stod(campo));
+            } catch (const std::exception &) {
+                throw std::runtime_error("linha " + std::to_string(numero) +
+                                         " do lote: valor inválido '" + campo + "'");
+            }
+        }
+        if (valores.empty()) continue;
+
+        if (columns.empty()) columns.resize(valores.size());
+        if (valores.size() != columns.size()) {
+            throw std::runtime_error("linha " + std::to_string(numero) + " do lote: esperava " +
+                                     std::to_string(columns.size()) + " valores");
+        }
+        for (size_t i = 0; i < valores.size(); ++i) columns[i].push_back(valores[i]);
+    }
+    return columns;
+}
+
+static size_t countNodes(const Node &node) {
+    size_t count = 1;
+    forEachChild(node, [&](const NodePtr &child) { count += countNodes(*child); });
+    return count;
+}
+
+int main(int argc, char **argv) {
+    bool useJit = false;
+    bool useMemo = false;
+    uint32_t memoCapacity = MemoCache::DEFAULT_CAPACITY;
+    bool optimize = true;
+    bool useFlatAst = false;
+    bool repl = false;
+    bool showStats = false;
+    size_t inlineBudget = Inliner::DEFAULT_BUDGET;
+    size_t threads = 0;             // 0 = núcleos disponíveis
+    std::string batchFunction;
+    std::string streamFunction;
+    StreamOptions stream;
+    std::vector<std::string> sourcePaths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--jit") {
+            useJit = true;
+        } else if (arg == "--no-opt") {
+            optimize = false;
+        } else if (arg == "--flat-ast") {
+            useFlatAst = true;
+        } else if (arg == "--repl") {
+            repl = true;
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--memo") {
+            useMemo = true;
+        } else if (arg.rfind("--memo=", 0) == 0) {
+            useMemo = true;
+            unsigned long capacity = 0;
+            try {
+                capacity = std::stoul(arg.substr(7));
+            } catch (const std::exception &) {
+                // fica 0, recusado abaixo junto com os valores fora da faixa
+            }
+            if (capacity == 0 || capacity > MemoCache::MAX_CAPACITY) {
+                std::cerr << "Valor inválido em " << arg << "\n";
+                return 1;
+            }
+            memoCapacity = static_cast<uint32_t>(capacity);
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batchFunction = arg.substr(8);
+        } else if (arg.rfind("--stream=", 0) == 0) {
+            streamFunction = arg.substr(9);
+        } else if (arg.rfind("--input=", 0) == 0) {
+            stream.input = arg.substr(8);
+        } else if (arg.rfind("--output=", 0) == 0) {
+            stream.output = arg.substr(9);
+        } else if (arg == "--binary") {
+            stream.format = StreamFormat::BINARY;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            try {
+                threads = std::stoul(arg.substr(10));
+            } catch (const std::exception &) {
+                std::cerr << "Valor inválido em " << arg << "\n";
+                return 1;
+            }
+        } else if (arg.rfind("--inline-budget=", 0) == 0) {
+            try {
+                inlineBudget = std::stoul(arg.substr(16));
+            } catch (const std::exception &) {
+                std::cerr << "Valor inválido em " << arg << "\n";
+                return 1;
+            }
+        } else if (arg == "--quiet" || arg == "-q") {
+            Trace::setLevel(TraceLevel::QUIET);
+        } else if (arg.rfind("--verbosity=", 0) == 0) {
+            std::string nivel = arg.substr(12);
+            if (nivel.size() != 1 || nivel[0] < '0' || nivel[0] > '3') {
+                std::cerr << "Valor inválido em " << arg << "\n";
+                return 1;
+            }
+            Trace::setLevel(static_cast<TraceLevel>(nivel[0] - '0'));
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            unsigned canais;
+            if (!Trace::parseChannels(arg.substr(8), canais)) {
+                std::cerr << "Valor inválido em " << arg << "\n";
+                return 1;
+            }
+            Trace::setChannels((Trace::getChannels() & Trace::SUMMARY) | canais);
+        } else if (arg == "-" || arg.rfind("--", 0) != 0) {
+            sourcePaths.push_back(arg);
+        } else {
+            std::cerr << "Opção desconhecida: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (!streamFunction.empty() && (stream.input.empty() || stream.output.empty())) {
+        std::cerr << "--stream exige --input=arquivo e --output=arquivo\n";
+        return 1;
+    }
+
+    std::ostream &out = Trace::out();
+
+    // Sessão: cada linha do stdin é compilada e executada sozinha, até o fim
+    // da entrada. Sem inlining nem otimizações, que atravessariam definições.
+    if (repl) {
+        if (useJit || useMemo || useFlatAst || showStats || !batchFunction.empty() ||
+            !streamFunction.empty() || !sourcePaths.empty()) {
+            std::cerr << "--repl não combina com arquivos, --jit, --memo, --flat-ast, --stats, --batch ou --stream\n";
+            return 1;
+        }
+        if (Trace::enabled(Trace::SUMMARY)) {
+            out << "Sessão interativa: redefinições recalculam só o que depende delas (fim com Ctrl-D)\n";
+        }
 
-    while (true) {
-        std::getline(std::cin, linha);
-        if (linha.empty()) break; 
-        buffer << linha << '\n';
+        Session session;
+        std::string linha;
+        while (std::getline(std::cin, linha)) {
+            if (!linha.empty()) session.submit(linha);
+        }
+        return 0;
     }
 
-    std::string codigo = buffer.str();
+    // Sem arquivos, lê do stdin até a primeira linha vazia. Com arquivos,
+    // cada um é mapeado em memória e lido inteiro pelo lexer, sem cópia;
+    // "-" lê o stdin até o fim.
+    std::string codigo;
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<std::pair<std::string, std::string_view>> sources;
+
+    if (sourcePaths.empty()) {
+        if (Trace::enabled(Trace::SUMMARY)) {
+            out << "Digite o código da linguagem (uma linha por vez, termine com linha vazia):\n";
+        }
+
+        std::stringstream buffer;
+        std::string linha;
 
-    std::cout << "\n+++ CÓDIGO RECEBIDO +++\n" << codigo << "\n";
+        while (true) {
+            if (!std::getline(std::cin, linha) || linha.empty()) break;
+            buffer << linha << '\n';
+        }
 
-    Lexer lexer(codigo);
-    auto tokens = lexer.tokenize();
+        codigo = buffer.str();
+        if (Trace::enabled(Trace::LEXER)) out << "\n+++ CÓDIGO RECEBIDO +++\n" << codigo << "\n";
+        sources.emplace_back("", codigo);
+    } else {
+        for (const auto &path : sourcePaths) {
+            std::string_view text;
+            if (path == "-") {
+                if (!codigo.empty()) {
+                    std::cerr << "Erro: o stdin só pode ser lido uma vez\n";
+                    return 1;
+                }
+                codigo.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+                text = codigo;
+            } else {
+                try {
+                    files.push_back(std::make_unique<MappedFile>(path));
+                } catch (const std::exception &e) {
+                    std::cerr << "Erro: " << e.what() << "\n";
+                    return 1;
+                }
+                text = files.back()->view();
+            }
+            if (Trace::enabled(Trace::SUMMARY)) {
+                out << "+++ ARQUIVO " << (path == "-" ? "<stdin>" : path) << " ("
+                    << text.size() << " bytes) +++\n";
+            }
+            sources.emplace_back(path == "-" ? "<stdin>" : path, text);
+        }
+    }
 
-    std::cout << "\n=== TOKENS ===\n";
-    for (auto &t : tokens) {
-        std::cout << "line:" << t.line << " col:" << t.column << " "
-                  << tokenTypeToString(t.type)
-                  << "('" << t.value << "')\n";
+    // Com --stats, o lexer roda antes sozinho para ser medido e contar os
+    // tokens; na compilação o parser continua puxando os tokens dele.
+    StatsReport stats(showStats);
+    if (stats.isEnabled()) {
+        stats.begin();
+        for (const auto &source : sources) {
+            Lexer lexer(source.second);
+            try {
+                for (++stats.tokens; lexer.next().type != TokenType::END_OF_FILE; ++stats.tokens) {}
+            } catch (const std::exception &) {
+                // o erro é mostrado pelo parser, logo abaixo
+            }
+        }
+        stats.end("lexer");
     }
 
-    Parser parser(tokens);
+    // Nós e nomes da AST ficam numa arena liberada de uma vez no fim.
+    Arena arena;
     std::vector<NodePtr> astList;
+    FlatAst flat;
 
-    try {
-        astList = parser.parseAll();
+    for (const auto &[name, text] : sources) {
+        // A listagem tokeniza o texto à parte; o parser puxa os tokens do
+        // lexer durante a análise, sem guardar o vetor inteiro.
+        if (Trace::enabled(Trace::LEXER)) {
+            Lexer listing(text);
+            out << "\n=== TOKENS" << (name.empty() ? "" : " (" + name + ")") << " ===\n";
+            for (auto &t : listing.tokenize()) {
+                SourceLocation at = listing.getLines().locate(t);
+                out << "line:" << at.line << " col:" << at.column << " "
+                    << tokenTypeToString(t.type)
+                    << "('" << t.value << "')\n";
+            }
+        }
+
+        stats.begin();
+        Lexer lexer(text);
+        Parser parser(lexer, arena);
+
+        try {
+            if (useFlatAst) {
+                parser.parseAllFlat(flat);
+            } else {
+                auto nodes = parser.parseAll();
+                for (auto &n : nodes) astList.push_back(std::move(n));
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "Erro de parser" << (name.empty() ? "" : " em " + name) << ": " << e.what() << "\n";
+            return 1;
+        }
+        stats.end("parser");
+    }
 
-        std::cout << "\n=== AST (Abstract Syntax Tree) ===\n";
+    if (stats.isEnabled()) {
+        stats.nodes = useFlatAst ? flat.nodeCount() : 0;
+        for (const auto &n : astList) {
+            if (n) stats.nodes += countNodes(*n);
+        }
+    }
+
+    if (Trace::enabled(Trace::PARSER)) {
+        out << "\n=== AST (Abstract Syntax Tree) ===\n";
+        if (useFlatAst) flat.prettyPrint();
         for (auto &n : astList) {
             n->prettyPrint();
         }
-
-    } catch (const std::exception &e) {
-        std::cerr << "Erro de parser: " << e.what() << "\n";
-        return 1;
     }
 
     try {
+        stats.begin();
         SemanticAnalyzer sem;
-        sem.analyze(astList);
-        std::cout << "\nAnálise semântica OK!\n";
+        sem.setThreads(threads);
+        if (useFlatAst) sem.analyze(flat);
+        else sem.analyze(astList);
+        stats.end("semântica");
+        stats.scopeLookups = sem.getLookups();
+        if (Trace::enabled(Trace::SUMMARY)) out << "\nAnálise semântica OK!\n";
+
+        if (optimize && useFlatAst) {
+            if (Trace::enabled(Trace::SUMMARY)) {
+                out << "\nAST plana: inlining e dobra de constantes não se aplicam\n";
+            }
+        } else if (optimize) {
+            stats.begin();
+            Inliner inliner(arena, inlineBudget);
+            inliner.run(astList);
+            if (Trace::enabled(Trace::SUMMARY)) {
+                out << "\nInlining: " << inliner.getInlinedCalls() << " chamadas expandidas\n";
+            }
+
+            if (inliner.getInlinedCalls() > 0) {
+                // corpos copiados trazem slots do frame da função chamada
+                SemanticAnalyzer reanalysis;
+                reanalysis.setThreads(threads);
+                reanalysis.analyze(astList);
+                stats.scopeLookups += reanalysis.getLookups();
+            }
+
+            Optimizer optimizer(arena);
+            optimizer.optimize(astList);
+            stats.end("otimização");
+            if (Trace::enabled(Trace::SUMMARY)) {
+                out << "Otimização: " << optimizer.getRemovedNodes() << " nós removidos\n";
+            }
+
+            if (Trace::enabled(Trace::PARSER) &&
+                (inliner.getInlinedCalls() > 0 || optimizer.getRemovedNodes() > 0)) {
+                out << "\n=== AST OTIMIZADA ===\n";
+                for (auto &n : astList) {
+                    n->prettyPrint();
+                }
+            }
+        }
 
     } catch (const std::exception &e) {
         std::cerr << e.what() << "\n";
         return 1;
     }
 
+    if (Trace::enabled(Trace::SUMMARY)) {
+        out << "Arena da AST: " << arena.bytesUsed() << " bytes usados em "
+            << arena.blockCount() << " blocos (" << arena.bytesReserved() << " reservados)\n";
+        if (useFlatAst) {
+            size_t nodes = flat.nodeCount();
+            out << "AST plana: " << nodes << " nós, " << flat.bytesUsed() << " bytes";
+            if (nodes > 0) out << " (" << flat.bytesUsed() / nodes << " bytes/nó)";
+            out << "\n";
+        }
+    }
+
     try {
+    stats.begin();
     CodeGenerator codegen;
-    codegen.generateCode(astList);
-    codegen.printCode();
+    codegen.setIrOptimization(optimize);
+    codegen.setThreads(threads);
+    if (useFlatAst) codegen.generateCode(flat);
+    else codegen.generateCode(astList);
+    stats.end("codegen");
+    stats.instructions = codegen.getProgram().main.code.size();
+    for (const auto &fn : codegen.getProgram().functions) stats.instructions += fn.code.size();
+    if (Trace::enabled(Trace::CODEGEN)) codegen.printCode();
+    if (optimize && Trace::enabled(Trace::SUMMARY)) {
+        const IrStats &ir = codegen.getIrStats();
+        out << "GVN: " << ir.redundant << " instruções redundantes eliminadas\n";
+        out << "DCE: " << ir.dead << " instruções mortas removidas\n";
+        out << "Registradores: " << ir.registersBefore << " -> " << ir.registersAfter << "\n";
+    }
+
+    // a execução conta desde a decodificação do bytecode (e a compilação do JIT)
+    stats.begin();
+    Interpreter interpreter(codegen.getProgram());
+    if (stats.isEnabled()) interpreter.setDispatchMode(DispatchMode::COUNTED);
+    auto report = [&] {
+        stats.end("execução");
+        stats.dispatched = interpreter.getCounters().instructions;
+        stats.calls = interpreter.getCounters().calls;
+        stats.print(out);
+    };
+    if (useJit) {
+        interpreter.setTrace(false);
+        size_t compiled = interpreter.enableJit();
+        if (Trace::enabled(Trace::SUMMARY)) {
+            out << "\nJIT: " << compiled << " de " << codegen.getProgram().functions.size()
+                << " funções compiladas para código nativo\n";
+        }
+    }
+    if (useMemo) {
+        interpreter.enableMemo(memoCapacity);
+    } else if ((useJit || !Trace::enabled(Trace::EXEC)) && ThreadPool::resolveThreads(threads) > 1) {
+        // comandos de topo independentes rodam em paralelo, na ordem do grafo
+        StatementGraph graph = buildStatementGraph(codegen.getProgram());
+        if (graph.worthParallel()) {
+            if (Trace::enabled(Trace::SUMMARY)) {
+                out << "\nExecução paralela: " << graph.units.size() << " unidades, "
+                    << graph.edges << " dependências\n";
+            }
+            interpreter.setSchedule(std::move(graph), threads);
+        }
+    }
+    if (!streamFunction.empty()) {
+        interpreter.setTrace(false);
+        interpreter.runProgram();
+
+        uint32_t function = BatchEvaluator::functionIndex(codegen.getProgram(), streamFunction);
+        stream.threads = threads;
+        StreamEvaluator evaluator(codegen.getProgram(), interpreter.getGlobals(), function);
+        StreamStats st = evaluator.run(stream);
+
+        if (Trace::enabled(Trace::SUMMARY)) {
+            out << "\n=== STREAM: " << streamFunction << " ===\n"
+                << st.rows << " linhas em " << st.chunks << " blocos, " << st.threads
+                << " threads, " << st.seconds << " s";
+            if (st.seconds > 0) out << " (" << st.rows / st.seconds << " linhas/s)";
+            out << "\nResultados gravados em " << stream.output << "\n";
+        }
+        report();
+        return 0;
+    }
+
+    if (!batchFunction.empty()) {
+        // o programa principal roda só para calcular as globais lidas pela função
+        interpreter.setTrace(false);
+        interpreter.runProgram();
+
+        BatchEvaluator batch(codegen.getProgram(), interpreter.getGlobals());
+        uint32_t function = BatchEvaluator::functionIndex(codegen.getProgram(), batchFunction);
+        std::vector<std::vector<double>> columns = readColumns(std::cin);
+        size_t rows = columns.empty() ? 0 : columns[0].size();
+        if (rows > 0 && columns.size() != codegen.getProgram().functions[function].params.size()) {
+            throw std::runtime_error("função '" + batchFunction + "' esperava " +
+                                     std::to_string(codegen.getProgram().functions[function].params.size()) +
+                                     " valores por linha, recebeu " + std::to_string(columns.size()));
+        }
+
+        std::vector<const double*> inputs;
+        for (const auto &column : columns) inputs.push_back(column.data());
+        std::vector<double> results(rows);
+        if (rows > 0) batch.evaluate(function, inputs, rows, results.data());
+
+        if (Trace::enabled(Trace::SUMMARY)) {
+            out << "\n=== AVALIAÇÃO EM LOTE: " << batchFunction << " (" << rows
+                << " linhas, kernel " << simdLevelName(batch.getSimdLevel()) << ") ===\n";
+        }
+        for (double value : results) out << value << "\n";
+        report();
+        return 0;
+    }
 
-    Interpreter interpreter(codegen.getCodeLines());
     interpreter.execute();
+    interpreter.printMemoStats();
+    report();
 
     } catch (const std::exception &e) {
         std::cerr << "Erro na geração/execução de código:: " << e.what() << "\n";
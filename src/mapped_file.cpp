@@ -0,0 +1,66 @@
+#include "../include/mapped_file.h"
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if MC_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &p) : path(p), base(""), length(0) {
+#if MC_HAS_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("não foi possível abrir '" + path + "': " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("não foi possível ler '" + path + "': " + std::strerror(errno));
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void *mem = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("não foi possível mapear '" + path + "': " + std::strerror(errno));
+        }
+        madvise(mem, length, MADV_SEQUENTIAL);
+        base = static_cast<const char *>(mem);
+    }
+    close(fd);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("não foi possível abrir '" + path + "'");
+    fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    length = fallback.size();
+    if (length > 0) base = fallback.data();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if MC_HAS_MMAP
+    if (length > 0) munmap(const_cast<char *>(base), length);
+#endif
+}
+
+void MappedFile::release(size_t offset, size_t bytes) const {
+#if MC_HAS_MMAP
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    // só páginas inteiras dentro da faixa; as das bordas podem ser de vizinhos
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = (offset + bytes) / page * page;
+    if (end > begin) {
+        madvise(const_cast<char *>(base) + begin, end - begin, MADV_DONTNEED);
+    }
+#else
+    (void)offset;
+    (void)bytes;
+#endif
+}
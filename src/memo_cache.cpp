@@ -0,0 +1,106 @@
+#include "../include/memo_cache.h"
+#include <algorithm>
+#include <cstring>
+
+MemoCache::MemoCache(uint32_t n, uint32_t cap)
+    : argc(n), capacity(cap > 0 ? std::min(cap, MAX_CAPACITY) : 1), count(0), hand(0), mask(0) {
+    keys.resize(static_cast<size_t>(capacity) * argc);
+    hashes.resize(capacity);
+    values.resize(capacity);
+    referenced.resize(capacity);
+
+    // fator de carga máximo de 1/2
+    uint32_t tableSize = 2;
+    while (tableSize < uint64_t{capacity} * 2) tableSize <<= 1;
+    table.assign(tableSize, 0);
+    mask = tableSize - 1;
+}
+
+static inline uint64_t bitsOf(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+uint64_t MemoCache::hashArgs(const double *args) const {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ argc;
+    for (uint32_t i = 0; i < argc; ++i) {
+        h ^= bitsOf(args[i]);
+        h *= 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+bool MemoCache::sameKey(uint32_t entry, const double *args) const {
+    const uint64_t *key = keys.data() + static_cast<size_t>(entry) * argc;
+    for (uint32_t i = 0; i < argc; ++i) {
+        if (key[i] != bitsOf(args[i])) return false;
+    }
+    return true;
+}
+
+bool MemoCache::lookup(const double *args, double &value) {
+    uint64_t h = hashArgs(args);
+    for (uint32_t pos = static_cast<uint32_t>(h) & mask;; pos = (pos + 1) & mask) {
+        uint32_t slot = table[pos];
+        if (slot == 0) break;
+        uint32_t entry = slot - 1;
+        if (hashes[entry] == h && sameKey(entry, args)) {
+            referenced[entry] = 1;
+            value = values[entry];
+            ++stats.hits;
+            return true;
+        }
+    }
+    ++stats.misses;
+    return false;
+}
+
+uint32_t MemoCache::findSlot(uint32_t entry) const {
+    uint32_t pos = static_cast<uint32_t>(hashes[entry]) & mask;
+    while (table[pos] != entry + 1) pos = (pos + 1) & mask;
+    return pos;
+}
+
+// Remoção com deslocamento para trás: mantém as sequências de sondagem sem
+// precisar de marcadores de posição apagada.
+void MemoCache::removeFromTable(uint32_t entry) {
+    uint32_t hole = findSlot(entry);
+    for (uint32_t pos = (hole + 1) & mask; table[pos] != 0; pos = (pos + 1) & mask) {
+        uint32_t home = static_cast<uint32_t>(hashes[table[pos] - 1]) & mask;
+        // a entrada em pos pode ocupar o buraco se o buraco está entre a
+        // posição de origem dela e pos (considerando a volta da tabela)
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            table[hole] = table[pos];
+            hole = pos;
+        }
+    }
+    table[hole] = 0;
+}
+
+uint32_t MemoCache::evict() {
+    while (referenced[hand]) {
+        referenced[hand] = 0;
+        hand = (hand + 1) % capacity;
+    }
+    uint32_t victim = hand;
+    hand = (hand + 1) % capacity;
+    removeFromTable(victim);
+    ++stats.evictions;
+    return victim;
+}
+
+void MemoCache::insert(const double *args, double value) {
+    uint32_t entry = count < capacity ? count++ : evict();
+
+    uint64_t *key = keys.data() + static_cast<size_t>(entry) * argc;
+    for (uint32_t i = 0; i < argc; ++i) key[i] = bitsOf(args[i]);
+    hashes[entry] = hashArgs(args);
+    values[entry] = value;
+    referenced[entry] = 0;
+
+    uint32_t pos = static_cast<uint32_t>(hashes[entry]) & mask;
+    while (table[pos] != 0) pos = (pos + 1) & mask;
+    table[pos] = entry + 1;
+}
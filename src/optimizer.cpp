@@ -0,0 +1,129 @@
+#include "../include/optimizer.h"
+#include "../include/bytecode.h"
+#include <cmath>
+#include <limits>
+#include <string>
+
+Optimizer::Optimizer(Arena &a) : arena(a), removedNodes(0) {}
+
+size_t Optimizer::countNodes(const Node *node) {
+    if (!node) return 0;
+
+    size_t total = 1;
+    forEachChild(*node, [&](const NodePtr &child) { total += countNodes(child.get()); });
+    return total;
+}
+
+static const NumberNode* asNumber(const NodePtr &node) {
+    return nodeAs<NumberNode>(node.get());
+}
+
+static bool isNumber(const NodePtr &node, double value) {
+    const NumberNode *num = asNumber(node);
+    return num && num->number() == value;
+}
+
+static bool isLeaf(const NodePtr &node) {
+    return node->kind == NodeKind::VAR || node->kind == NodeKind::NUMBER;
+}
+
+NodePtr Optimizer::cloneLeaf(const NodePtr &node) {
+    if (auto var = nodeAs<VarNode>(node.get())) {
+        auto copy = makeNode<VarNode>(arena, var->name);
+        copy->type = var->type;
+        copy->slot = var->slot;
+        return copy;
+    }
+    auto num = asNumber(node);
+    auto copy = makeNode<NumberNode>(arena, num->value);
+    copy->type = num->type;
+    return copy;
+}
+
+// Mesma semântica do interpretador, inclusive divisão por zero resultando NaN.
+static double evaluate(Operator op, double l, double r) {
+    switch (op) {
+        case Operator::ADD: return l + r;
+        case Operator::SUB: return l - r;
+        case Operator::MUL: return l * r;
+        case Operator::DIV: return r == 0.0 ? std::numeric_limits<double>::quiet_NaN() : l / r;
+        default: return std::pow(l, r);
+    }
+}
+
+NodePtr Optimizer::makeNumber(double value, Type type) {
+    auto num = makeNode<NumberNode>(arena, arena.copy(formatNumber(value)));
+    num->type = type;
+    return num;
+}
+
+NodePtr Optimizer::foldBinary(ArenaPtr<BinaryOpNode> node) {
+    node->left = fold(std::move(node->left));
+    node->right = fold(std::move(node->right));
+
+    const NumberNode *l = asNumber(node->left);
+    const NumberNode *r = asNumber(node->right);
+    if (l && r) {
+        return makeNumber(evaluate(node->op, l->number(), r->number()), node->type);
+    }
+
+    // Identidades só valem se o tipo do operando que sobra for o do resultado.
+    // `x + 0` e `0 - x` ficam de fora: com x = -0, 0 ou nan o sinal muda.
+    auto keep = [&](NodePtr &side) -> NodePtr {
+        if (side->type != node->type) return nullptr;
+        return std::move(side);
+    };
+
+    Operator op = node->op;
+    NodePtr simplified;
+    if (op == Operator::MUL && isNumber(node->right, 1.0)) simplified = keep(node->left);
+    else if (op == Operator::MUL && isNumber(node->left, 1.0)) simplified = keep(node->right);
+    else if (op == Operator::SUB && isNumber(node->right, 0.0)) simplified = keep(node->left);
+    else if ((op == Operator::DIV || op == Operator::POW) && isNumber(node->right, 1.0)) simplified = keep(node->left);
+    if (simplified) return simplified;
+
+    if (op == Operator::POW && isNumber(node->right, 2.0) && isLeaf(node->left)) {
+        NodePtr copy = cloneLeaf(node->left);
+        auto square = makeNode<BinaryOpNode>(arena, Operator::MUL, std::move(node->left), std::move(copy));
+        square->type = node->type;
+        square->slot = node->slot;
+        return square;
+    }
+
+    return node;
+}
+
+NodePtr Optimizer::foldUnary(ArenaPtr<UnaryOpNode> node) {
+    node->operand = fold(std::move(node->operand));
+
+    if (const NumberNode *num = asNumber(node->operand)) {
+        return makeNumber(-num->number(), node->type);
+    }
+    return node;
+}
+
+NodePtr Optimizer::fold(NodePtr node) {
+    if (!node) return node;
+
+    switch (node->kind) {
+        case NodeKind::BINARY_OP:
+            return foldBinary(ArenaPtr<BinaryOpNode>(static_cast<BinaryOpNode*>(node.release())));
+        case NodeKind::UNARY_OP:
+            return foldUnary(ArenaPtr<UnaryOpNode>(static_cast<UnaryOpNode*>(node.release())));
+        default:
+            forEachChild(*node, [&](NodePtr &child) { child = fold(std::move(child)); });
+            break;
+    }
+    return node;
+}
+
+void Optimizer::optimize(std::vector<NodePtr> &ast) {
+    size_t before = 0;
+    size_t after = 0;
+    for (auto &node : ast) {
+        before += countNodes(node.get());
+        node = fold(std::move(node));
+        after += countNodes(node.get());
+    }
+    removedNodes = before - after;
+}
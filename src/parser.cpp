@@ -2,24 +2,118 @@
 #include <stdexcept>
 #include <iostream>
 
-Parser::Parser(const std::vector<Token>& toks) : tokens(toks), idx(0) {}
+namespace {
+
+// Monta a árvore de Node na arena.
+struct TreeBuilder {
+    using Ref = NodePtr;
+    using Params = std::pmr::vector<Symbol>;
+    using Args = std::pmr::vector<NodePtr>;
+
+    Arena &arena;
+
+    Ref number(std::string_view text) { return makeNode<NumberNode>(arena, arena.copy(text)); }
+    Ref var(Symbol name) { return makeNode<VarNode>(arena, name); }
+    Ref binary(Operator op, Ref left, Ref right) {
+        return makeNode<BinaryOpNode>(arena, op, std::move(left), std::move(right));
+    }
+    Args arguments() { return Args(&arena); }
+    void argument(Args &args, Ref arg) { args.push_back(std::move(arg)); }
+    Ref call(Symbol name, Args args) { return makeNode<FuncCallNode>(arena, name, std::move(args)); }
+    Ref assign(Symbol name, Ref expr) { return makeNode<AssignNode>(arena, name, std::move(expr)); }
+    Params parameters() { return Params(&arena); }
+    void parameter(Params &params, Symbol name) { params.push_back(name); }
+    Ref declaration(Symbol name, Params params) {
+        return makeNode<FuncDeclNode>(arena, name, std::move(params), nullptr);
+    }
+    Ref finishDeclaration(Ref decl, Ref body) {
+        static_cast<FuncDeclNode&>(*decl).body = std::move(body);
+        return decl;
+    }
+};
+
+// Grava os nós em FlatAst, em pós-ordem. O nó da declaração vem antes do
+// corpo; a lista de parâmetros termina com o índice do corpo, preenchido
+// depois de lê-lo.
+struct FlatBuilder {
+    using Ref = uint32_t;
+    using Params = uint32_t;   // posição da lista em lists
+    using Args = size_t;       // início dos argumentos em pending
+
+    FlatAst &flat;
+    // argumentos podem conter chamadas, então ficam numa pilha até o fim da
+    // lista e só então são copiados para lists
+    std::vector<uint32_t> pending;
+
+    Ref number(std::string_view text) { return flat.addNumber(text); }
+    Ref var(Symbol name) { return flat.addNode(FlatKind::VAR, Operator::NONE, name, 0); }
+    Ref binary(Operator op, Ref left, Ref right) { return flat.addNode(FlatKind::BINARY, op, left, right); }
+    Args arguments() { return pending.size(); }
+    void argument(Args, Ref arg) { pending.push_back(arg); }
+    Ref call(Symbol name, Args base) {
+        uint32_t list = static_cast<uint32_t>(flat.lists.size());
+        flat.lists.push_back(static_cast<uint32_t>(pending.size() - base));
+        flat.lists.insert(flat.lists.end(), pending.begin() + base, pending.end());
+        pending.resize(base);
+        return flat.addNode(FlatKind::CALL, Operator::NONE, name, list);
+    }
+    Ref assign(Symbol name, Ref expr) { return flat.addNode(FlatKind::ASSIGN, Operator::NONE, name, expr); }
+    Params parameters() {
+        flat.lists.push_back(0);
+        return static_cast<uint32_t>(flat.lists.size() - 1);
+    }
+    void parameter(Params, Symbol name) { flat.lists.push_back(name); }
+    Ref declaration(Symbol name, Params list) {
+        flat.lists[list] = static_cast<uint32_t>(flat.lists.size() - list - 1);
+        flat.lists.push_back(FlatAst::NO_NODE);
+        return flat.addNode(FlatKind::FUNC_DECL, Operator::NONE, name, list);
+    }
+    Ref finishDeclaration(Ref decl, Ref body) {
+        uint32_t list = flat.b[decl];
+        flat.lists[list + flat.lists[list] + 1] = body;
+        return decl;
+    }
+};
+
+}
+
+Parser::Parser(Lexer &l, Arena &a) : lexer(l), head(0), arena(a) {
+    for (auto &token : window) token = lexer.next();
+}
 
 std::vector<NodePtr> Parser::parseAll() {
     std::vector<NodePtr> statements;
+    TreeBuilder build{arena};
 
     while (current().type != TokenType::END_OF_FILE) {
-        statements.push_back(parseProgram());
+        statements.push_back(parseProgram(build));
     }
 
     return statements;
 }
 
+void Parser::parseAllFlat(FlatAst &out) {
+    FlatBuilder build{out, {}};
+
+    while (current().type != TokenType::END_OF_FILE) {
+        uint32_t first = static_cast<uint32_t>(out.nodeCount());
+        parseProgram(build);
+        out.statements.push_back({first, static_cast<uint32_t>(out.nodeCount() - 1)});
+    }
+}
+
 const Token& Parser::current() const {
-    return tokens[idx];
+    return window[head];
+}
+
+const Token& Parser::peek(size_t n) const {
+    return window[(head + n) % LOOKAHEAD];
 }
 
 void Parser::advance() {
-    if (tokens[idx].type != TokenType::END_OF_FILE) idx++;
+    if (current().type == TokenType::END_OF_FILE) return;
+    window[head] = lexer.next();
+    head = (head + 1) % LOOKAHEAD;
 }
 
 bool Parser::accept(TokenType t) {
@@ -27,166 +121,176 @@ bool Parser::accept(TokenType t) {
     return false;
 }
 
-bool Parser::acceptValue(TokenType t, const std::string &val) {
-    if (current().type == t && current().value == val) { advance(); return true; }
-    return false;
+bool Parser::isOperator(Operator op) const {
+    return current().type == TokenType::OP_ARIT && current().op == op;
 }
 
 void Parser::expect(TokenType t, const std::string &msg) {
     if (current().type != t) {
-        throw std::runtime_error("Parse error at line " + std::to_string(current().line) +
-                                 " col " + std::to_string(current().column) +
+        SourceLocation at = lexer.getLines().locate(current());
+        throw std::runtime_error("Parse error at line " + std::to_string(at.line) +
+                                 " col " + std::to_string(at.column) +
                                  ": expected " + tokenTypeToString(t) + " (" + msg + "), got " +
-                                 tokenTypeToString(current().type) + " '" + current().value + "'");
+                                 tokenTypeToString(current().type) + " '" + std::string(current().value) + "'");
     }
     advance();
 }
 
 NodePtr Parser::parse() {
     if (current().type == TokenType::END_OF_FILE) return nullptr;
-    NodePtr n = parseProgram();
+    TreeBuilder build{arena};
+    NodePtr n = parseProgram(build);
     if (current().type != TokenType::END_OF_FILE) {
         throw std::runtime_error("Extra tokens after end of statement at line " +
-                                 std::to_string(current().line));
+                                 std::to_string(lexer.getLines().locate(current()).line));
     }
     return n;
 }
 
-NodePtr Parser::parseProgram() {
+template<typename Builder>
+typename Builder::Ref Parser::parseProgram(Builder &build) {
     if (current().type == TokenType::FUNC) {
-        return parseDeclaration();
+        return parseDeclaration(build);
     }
     else if (current().type == TokenType::ID) {
         
-        if (tokens.size() > idx+1 && tokens[idx+1].type == TokenType::ATRIB) {
-            return parseAssignment();
+        if (peek(1).type == TokenType::ATRIB) {
+            return parseAssignment(build);
         } else {
             
-            NodePtr expr = parseExpression();
-            return expr;
+            return parseExpression(build);
         }
     } else {
-        throw std::runtime_error("Unexpected token at start of statement: " + current().value);
+        throw std::runtime_error("Unexpected token at start of statement: " + std::string(current().value));
     }
 }
 
-NodePtr Parser::parseDeclaration() {
+template<typename Builder>
+typename Builder::Ref Parser::parseDeclaration(Builder &build) {
     
     expect(TokenType::FUNC, "'funcao' keyword");
     if (current().type != TokenType::ID) throw std::runtime_error("Expected function name after 'funcao'");
-    std::string name = current().value;
+    Symbol name = current().symbol;
     advance();
     expect(TokenType::LPAREN, "'(' after function name");
-    std::vector<std::string> params = parseParameters();
+    typename Builder::Params params = parseParameters(build);
     expect(TokenType::RPAREN, "')' after params");
     expect(TokenType::ATRIB, "'=' before function body");
-    NodePtr body = parseExpression();
-    return std::make_unique<FuncDeclNode>(name, params, std::move(body));
+    typename Builder::Ref decl = build.declaration(name, std::move(params));
+    typename Builder::Ref body = parseExpression(build);
+    return build.finishDeclaration(std::move(decl), std::move(body));
 }
 
-std::vector<std::string> Parser::parseParameters() {
-    std::vector<std::string> out;
+template<typename Builder>
+typename Builder::Params Parser::parseParameters(Builder &build) {
+    typename Builder::Params out = build.parameters();
     if (current().type == TokenType::RPAREN) return out; 
     if (current().type != TokenType::ID) throw std::runtime_error("Expected parameter name");
-    out.push_back(current().value);
+    build.parameter(out, current().symbol);
     advance();
     while (accept(TokenType::COMMA)) {
         if (current().type != TokenType::ID) throw std::runtime_error("Expected parameter name after ','");
-        out.push_back(current().value);
+        build.parameter(out, current().symbol);
         advance();
     }
     return out;
 }
 
-NodePtr Parser::parseAssignment() {
+template<typename Builder>
+typename Builder::Ref Parser::parseAssignment(Builder &build) {
     if (current().type != TokenType::ID) throw std::runtime_error("Expected identifier at assignment start");
-    std::string name = current().value;
+    Symbol name = current().symbol;
     advance();
     expect(TokenType::ATRIB, "'=' in assignment");
-    NodePtr expr = parseExpression();
-    return std::make_unique<AssignNode>(name, std::move(expr));
+    typename Builder::Ref expr = parseExpression(build);
+    return build.assign(name, std::move(expr));
 }
 
-NodePtr Parser::parseExpression() {
-    NodePtr node = parseTerm();
-    while (current().type == TokenType::OP_ARIT && (current().value == "+" || current().value == "-")) {
-        std::string op = current().value;
+template<typename Builder>
+typename Builder::Ref Parser::parseExpression(Builder &build) {
+    typename Builder::Ref node = parseTerm(build);
+    while (isOperator(Operator::ADD) || isOperator(Operator::SUB)) {
+        Operator op = current().op;
         advance();
-        NodePtr right = parseTerm();
-        node = std::make_unique<BinaryOpNode>(op, std::move(node), std::move(right));
+        typename Builder::Ref right = parseTerm(build);
+        node = build.binary(op, std::move(node), std::move(right));
     }
     return node;
 }
 
-NodePtr Parser::parseTerm() {
-    NodePtr node = parsePower();
-    while (current().type == TokenType::OP_ARIT && (current().value == "*" || current().value == "/")) {
-        std::string op = current().value;
+template<typename Builder>
+typename Builder::Ref Parser::parseTerm(Builder &build) {
+    typename Builder::Ref node = parsePower(build);
+    while (isOperator(Operator::MUL) || isOperator(Operator::DIV)) {
+        Operator op = current().op;
         advance();
-        NodePtr right = parsePower();
-        node = std::make_unique<BinaryOpNode>(op, std::move(node), std::move(right));
+        typename Builder::Ref right = parsePower(build);
+        node = build.binary(op, std::move(node), std::move(right));
     }
     return node;
 }
 
-NodePtr Parser::parsePower() {
-    NodePtr node = parseUnary();
-    if (current().type == TokenType::OP_ARIT && current().value == "^") {
-        std::string op = current().value;
+template<typename Builder>
+typename Builder::Ref Parser::parsePower(Builder &build) {
+    typename Builder::Ref node = parseUnary(build);
+    if (isOperator(Operator::POW)) {
         advance();
-        NodePtr right = parsePower(); 
-        node = std::make_unique<BinaryOpNode>(op, std::move(node), std::move(right));
+        typename Builder::Ref right = parsePower(build); 
+        node = build.binary(Operator::POW, std::move(node), std::move(right));
     }
     return node;
 }
 
-NodePtr Parser::parseUnary() {
-    if (current().type == TokenType::OP_ARIT && current().value == "-") {
-        std::string op = current().value;
+// -x vira 0 - x; o zero é criado antes do operando para que a AST plana
+// fique em pós-ordem da esquerda para a direita.
+template<typename Builder>
+typename Builder::Ref Parser::parseUnary(Builder &build) {
+    if (isOperator(Operator::SUB)) {
         advance();
-        NodePtr operand = parseUnary();
-        
-        auto zeroNode = std::make_unique<NumberNode>("0");
-        return std::make_unique<BinaryOpNode>(op, std::move(zeroNode), std::move(operand));
+        typename Builder::Ref zero = build.number("0");
+        typename Builder::Ref operand = parseUnary(build);
+        return build.binary(Operator::SUB, std::move(zero), std::move(operand));
     }
     
-    return parseFactor();
+    return parseFactor(build);
 }
 
-std::vector<NodePtr> Parser::parseArguments() {
-    std::vector<NodePtr> out;
+template<typename Builder>
+typename Builder::Args Parser::parseArguments(Builder &build) {
+    typename Builder::Args out = build.arguments();
     if (current().type == TokenType::RPAREN) return out; 
-    out.push_back(parseExpression());
+    build.argument(out, parseExpression(build));
     while (accept(TokenType::COMMA)) {
-        out.push_back(parseExpression());
+        build.argument(out, parseExpression(build));
     }
     return out;
 }
 
-NodePtr Parser::parseFactor() {
+template<typename Builder>
+typename Builder::Ref Parser::parseFactor(Builder &build) {
     if (current().type == TokenType::NUM) {
-        std::string v = current().value; 
+        typename Builder::Ref node = build.number(current().value);
         advance();
-        return std::make_unique<NumberNode>(v);
+        return node;
     }
     else if (current().type == TokenType::ID) {
-        std::string name = current().value;
+        Symbol name = current().symbol;
         advance();
         if (accept(TokenType::LPAREN)) {
             
-            std::vector<NodePtr> args = parseArguments();
+            typename Builder::Args args = parseArguments(build);
             expect(TokenType::RPAREN, "')' after function arguments");
-            return std::make_unique<FuncCallNode>(name, std::move(args));
+            return build.call(name, std::move(args));
         } else {
-            return std::make_unique<VarNode>(name);
+            return build.var(name);
         }
     }
     else if (accept(TokenType::LPAREN)) {
-        NodePtr inside = parseExpression();
+        typename Builder::Ref inside = parseExpression(build);
         expect(TokenType::RPAREN, "')' expected");
         return inside;
     }
     else {
-        throw std::runtime_error("Unexpected token in factor: " + current().value);
+        throw std::runtime_error("Unexpected token in factor: " + std::string(current().value));
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,249 @@
+#include "../include/schedule.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t NONE = UINT32_MAX;
+
+// Operandos lidos por uma instrução; CALL lê os argumentos escritos pelos ARG.
+template<typename Fn>
+void forEachRead(const Instruction &ins, Fn &&fn) {
+    switch (ins.op) {
+        case OpCode::CALL:
+            break;
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+        case OpCode::DIV: case OpCode::POW:
+            fn(ins.a);
+            fn(ins.b);
+            break;
+        default:
+            fn(ins.a);
+            break;
+    }
+}
+
+bool writesDst(const Instruction &ins) {
+    return ins.op != OpCode::ARG && ins.op != OpCode::RET && ins.op != OpCode::PRINT;
+}
+
+void mergeInto(std::vector<uint32_t> &target, const std::vector<uint32_t> &source) {
+    if (source.empty()) return;
+    std::vector<uint32_t> merged;
+    merged.reserve(target.size() + source.size());
+    std::set_union(target.begin(), target.end(), source.begin(), source.end(), std::back_inserter(merged));
+    target.swap(merged);
+}
+
+void sortUnique(std::vector<uint32_t> &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+// Globais lidas por cada função, direta ou indiretamente, em ordem crescente.
+// As funções são visitadas em pós-ordem do grafo de chamadas (quem é chamado
+// antes de quem chama), então uma passada basta; recursões pedem mais uma.
+std::vector<std::vector<uint32_t>> functionReads(const Program &program) {
+    size_t count = program.functions.size();
+    std::vector<std::vector<uint32_t>> reads(count), callees(count);
+
+    for (size_t f = 0; f < count; ++f) {
+        for (const auto &ins : program.functions[f].code) {
+            if (ins.op == OpCode::CALL) callees[f].push_back(ins.a);
+            forEachRead(ins, [&](uint32_t operand) {
+                if (operand != NO_OPERAND && operandKind(operand) == OperandKind::GLOBAL) {
+                    reads[f].push_back(operandIndex(operand));
+                }
+            });
+        }
+        sortUnique(reads[f]);
+        sortUnique(callees[f]);
+    }
+
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> visited(count, 0);
+    std::vector<std::pair<uint32_t, size_t>> stack;
+    for (uint32_t root = 0; root < count; ++root) {
+        if (visited[root]) continue;
+        visited[root] = 1;
+        stack.push_back({root, 0});
+        while (!stack.empty()) {
+            uint32_t f = stack.back().first;
+            size_t next = stack.back().second++;
+            if (next < callees[f].size()) {
+                uint32_t callee = callees[f][next];
+                if (!visited[callee]) {
+                    visited[callee] = 1;
+                    stack.push_back({callee, 0});
+                }
+            } else {
+                order.push_back(f);
+                stack.pop_back();
+            }
+        }
+    }
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (uint32_t f : order) {
+            size_t before = reads[f].size();
+            for (uint32_t callee : callees[f]) {
+                if (callee != f) mergeInto(reads[f], reads[callee]);
+            }
+            if (reads[f].size() != before) changed = true;
+        }
+    }
+    return reads;
+}
+
+struct Access {
+    uint32_t begin;
+    uint32_t end;
+    bool calls = false;
+    std::vector<uint32_t> reads;
+    std::vector<uint32_t> writes;
+};
+
+}
+
+bool StatementGraph::worthParallel() const {
+    size_t withCalls = 0;
+    for (const auto &unit : units) {
+        if (unit.calls && ++withCalls >= 2) return true;
+    }
+    return false;
+}
+
+StatementGraph buildStatementGraph(const Program &program) {
+    StatementGraph graph;
+    graph.code = program.main.code;
+    auto &code = graph.code;
+    uint32_t size = static_cast<uint32_t>(code.size());
+
+    // Corta o código depois de cada escrita em global ou PRINT (fim de um
+    // comando). A numeração de valores reaproveita resultados entre comandos
+    // em registradores: se o valor lido ainda está numa global, a leitura
+    // passa a ser dela; senão as unidades entre a escrita e a leitura são
+    // fundidas.
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    uint32_t numRegs = program.main.numRegs;
+    std::vector<uint32_t> regWriter(numRegs, NONE);
+    std::vector<uint32_t> regGlobal(numRegs, NONE);
+    std::vector<uint32_t> globalReg(program.globals.size(), NONE);
+    uint32_t begin = 0;
+    bool pendingArgs = false;
+
+    auto forget = [&](uint32_t reg, uint32_t global) {
+        if (reg != NONE) regGlobal[reg] = NONE;
+        if (global != NONE) globalReg[global] = NONE;
+    };
+
+    for (uint32_t i = 0; i < size; ++i) {
+        Instruction &ins = code[i];
+        auto crossing = [&](uint32_t &operand) {
+            if (operand == NO_OPERAND || operandKind(operand) != OperandKind::REG) return;
+            uint32_t reg = operandIndex(operand);
+            if (reg >= numRegs || regWriter[reg] == NONE || regWriter[reg] >= begin) return;
+            if (regGlobal[reg] != NONE) {
+                operand = makeOperand(OperandKind::GLOBAL, regGlobal[reg]);
+                return;
+            }
+            while (!ranges.empty() && ranges.back().second > regWriter[reg]) {
+                begin = ranges.back().first;
+                ranges.pop_back();
+            }
+        };
+        if (ins.op != OpCode::CALL) crossing(ins.a);
+        if (ins.op >= OpCode::ADD && ins.op <= OpCode::POW) crossing(ins.b);
+
+        bool writesGlobal = writesDst(ins) && operandKind(ins.dst) == OperandKind::GLOBAL;
+        if (writesGlobal) {
+            uint32_t global = operandIndex(ins.dst);
+            forget(globalReg[global], global);
+            if (ins.op == OpCode::MOV && operandKind(ins.a) == OperandKind::REG &&
+                operandIndex(ins.a) < numRegs) {
+                uint32_t reg = operandIndex(ins.a);
+                forget(reg, regGlobal[reg]);
+                regGlobal[reg] = global;
+                globalReg[global] = reg;
+            }
+        } else if (writesDst(ins) && operandKind(ins.dst) == OperandKind::REG &&
+                   operandIndex(ins.dst) < numRegs) {
+            uint32_t reg = operandIndex(ins.dst);
+            regWriter[reg] = i;
+            forget(reg, regGlobal[reg]);
+        }
+        if (ins.op == OpCode::ARG) pendingArgs = true;
+        if (ins.op == OpCode::CALL) pendingArgs = false;
+
+        if ((writesGlobal || ins.op == OpCode::PRINT) && !pendingArgs) {
+            ranges.push_back({begin, i + 1});
+            begin = i + 1;
+        }
+    }
+    if (begin < size) ranges.push_back({begin, size});
+
+    std::vector<std::vector<uint32_t>> calleeReads = functionReads(program);
+    std::vector<Access> accesses;
+    for (const auto &[first, last] : ranges) {
+        Access access;
+        access.begin = first;
+        access.end = last;
+        for (uint32_t i = first; i < last; ++i) {
+            const Instruction &ins = code[i];
+            if (ins.op == OpCode::CALL) {
+                access.calls = true;
+                access.reads.insert(access.reads.end(), calleeReads[ins.a].begin(), calleeReads[ins.a].end());
+            }
+            forEachRead(ins, [&](uint32_t operand) {
+                if (operand != NO_OPERAND && operandKind(operand) == OperandKind::GLOBAL) {
+                    access.reads.push_back(operandIndex(operand));
+                }
+            });
+            if (writesDst(ins) && operandKind(ins.dst) == OperandKind::GLOBAL) {
+                access.writes.push_back(operandIndex(ins.dst));
+            }
+        }
+        sortUnique(access.reads);
+        sortUnique(access.writes);
+
+        if (!access.calls && !accesses.empty() && !accesses.back().calls) {
+            Access &previous = accesses.back();
+            previous.end = access.end;
+            mergeInto(previous.reads, access.reads);
+            mergeInto(previous.writes, access.writes);
+        } else {
+            accesses.push_back(std::move(access));
+        }
+    }
+
+    std::vector<uint32_t> lastWriter(program.globals.size(), NONE);
+    std::vector<std::vector<uint32_t>> readers(program.globals.size());
+
+    for (uint32_t u = 0; u < accesses.size(); ++u) {
+        const Access &access = accesses[u];
+        MainUnit unit;
+        unit.begin = access.begin;
+        unit.end = access.end;
+        unit.calls = access.calls;
+
+        for (uint32_t g : access.reads) {
+            if (lastWriter[g] != NONE) unit.deps.push_back(lastWriter[g]);
+        }
+        for (uint32_t g : access.writes) {
+            if (lastWriter[g] != NONE) unit.deps.push_back(lastWriter[g]);
+            unit.deps.insert(unit.deps.end(), readers[g].begin(), readers[g].end());
+        }
+        sortUnique(unit.deps);
+        graph.edges += unit.deps.size();
+
+        for (uint32_t g : access.reads) readers[g].push_back(u);
+        for (uint32_t g : access.writes) {
+            lastWriter[g] = u;
+            readers[g].clear();
+        }
+        graph.units.push_back(std::move(unit));
+    }
+    return graph;
+}
@@ -1,7 +1,14 @@
 #include "../include/semantic.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <exception>
 #include <iostream>
 
-SemanticAnalyzer::SemanticAnalyzer() {
+SemanticAnalyzer::SemanticAnalyzer() : SemanticAnalyzer(nullptr) {}
+
+SemanticAnalyzer::SemanticAnalyzer(const SemanticAnalyzer *shared)
+    : globalCount(0), frameBase(0), tempCount(0), mainFrameSize(0), threads(0),
+      lookups(0), shared(shared), position(0), recording(false) {
     pushScope(); 
 }
 
@@ -13,34 +20,72 @@ void SemanticAnalyzer::popScope() {
     if (!variableScopes.empty()) variableScopes.pop_back();
 }
 
-void SemanticAnalyzer::declareVariable(const std::string &name, Type type) {
-    variableScopes.back()[name] = VariableInfo{type, true};
+Slot SemanticAnalyzer::declareVariable(Symbol name, Type type) {
+    auto &scope = variableScopes.back();
+    auto found = scope.find(name);
+    if (found != scope.end()) {
+        if (recording && found->second.type != type) {
+            timeline[name].push_back({position, VariableInfo{type, true, found->second.slot}});
+        }
+        found->second.type = type;
+        return found->second.slot;
+    }
+
+    Slot slot{SlotKind::GLOBAL, globalCount++};
+    scope[name] = VariableInfo{type, true, slot};
+    if (recording) timeline[name].push_back({position, scope[name]});
+    return slot;
 }
 
-bool SemanticAnalyzer::isVariableDeclared(const std::string &name) const {
-    for (auto it = variableScopes.rbegin(); it != variableScopes.rend(); ++it) {
-        if (it->count(name)) return true;
-    }
-    return false;
+Slot SemanticAnalyzer::declareParameter(Symbol name, uint32_t index) {
+    Slot slot{SlotKind::LOCAL, index};
+    variableScopes.back()[name] = VariableInfo{Type::UNKNOWN, true, slot};
+    return slot;
 }
 
-Type SemanticAnalyzer::getVariableType(const std::string &name) const {
+const VariableInfo* SemanticAnalyzer::findVariable(Symbol name) const {
+    ++lookups;
     for (auto it = variableScopes.rbegin(); it != variableScopes.rend(); ++it) {
         auto found = it->find(name);
-        if (found != it->end()) return found->second.type;
+        if (found != it->end()) return &found->second;
     }
-    return Type::UNKNOWN;
+    if (!shared) return nullptr;
+
+    // última versão gravada antes do comando que está sendo analisado
+    auto versions = shared->timeline.find(name);
+    if (versions == shared->timeline.end()) return nullptr;
+    auto after = std::partition_point(versions->second.begin(), versions->second.end(),
+                                      [&](const GlobalVersion &v) { return v.statement < position; });
+    return after == versions->second.begin() ? nullptr : &std::prev(after)->info;
+}
+
+bool SemanticAnalyzer::isVariableDeclared(Symbol name) const {
+    return findVariable(name) != nullptr;
+}
+
+Type SemanticAnalyzer::getVariableType(Symbol name) const {
+    const VariableInfo *info = findVariable(name);
+    return info ? info->type : Type::UNKNOWN;
+}
+
+Slot SemanticAnalyzer::getVariableSlot(Symbol name) const {
+    const VariableInfo *info = findVariable(name);
+    return info ? info->slot : Slot{};
+}
+
+Slot SemanticAnalyzer::allocateTemp() {
+    return Slot{SlotKind::LOCAL, frameBase + tempCount++};
 }
 
 void SemanticAnalyzer::registerFunction(const FuncDeclNode *func) {
     if (functions.count(func->name)) {
-        throw SemanticError("função '" + func->name + "' já declarada.");
+        throw SemanticError("função '" + std::string(Symbols::name(func->name)) + "' já declarada.");
     }
 
     Type returnType = Type::UNKNOWN;
-    if (auto num = dynamic_cast<const NumberNode*>(func->body.get())) {
+    if (auto num = nodeAs<NumberNode>(func->body.get())) {
         returnType = num->type;
-    } else if (auto var = dynamic_cast<const VarNode*>(func->body.get())) {
+    } else if (auto var = nodeAs<VarNode>(func->body.get())) {
         returnType = getVariableType(var->name);
     }
 
@@ -51,14 +96,14 @@ void SemanticAnalyzer::registerFunction(const FuncDeclNode *func) {
     };
 }
 
-bool SemanticAnalyzer::isFunctionDeclared(const std::string &name) const {
-    return functions.count(name) > 0;
+bool SemanticAnalyzer::isFunctionDeclared(Symbol name) const {
+    return registry().count(name) > 0;
 }
 
-FunctionInfo SemanticAnalyzer::getFunctionInfo(const std::string &name) const {
-    auto it = functions.find(name);
-    if (it == functions.end()) {
-        throw SemanticError("função '" + name + "' não encontrada.");
+FunctionInfo SemanticAnalyzer::getFunctionInfo(Symbol name) const {
+    auto it = registry().find(name);
+    if (it == registry().end()) {
+        throw SemanticError("função '" + std::string(Symbols::name(name)) + "' não encontrada.");
     }
     return it->second;
 }
@@ -66,45 +111,51 @@ FunctionInfo SemanticAnalyzer::getFunctionInfo(const std::string &name) const {
 Type SemanticAnalyzer::analyzeNode(NodePtr &node) {
     if (!node) return Type::UNKNOWN;
 
-    if (auto n = dynamic_cast<AssignNode*>(node.get())) {
-        return analyzeAssign(n);
-    } else if (auto n = dynamic_cast<FuncDeclNode*>(node.get())) {
-        return analyzeFuncDecl(n);
-    } else if (auto n = dynamic_cast<BinaryOpNode*>(node.get())) {
-        return analyzeBinary(n);
-    } else if (auto n = dynamic_cast<VarNode*>(node.get())) {
-        return analyzeVar(n);
-    } else if (auto n = dynamic_cast<FuncCallNode*>(node.get())) {
-        return analyzeFuncCall(n);
-    } else if (auto n = dynamic_cast<const NumberNode*>(node.get())) {
-        return analyzeNumber(n);
-    }
+    Type result = visitNode(*node, Overloaded{
+        [&](AssignNode &n) { return analyzeAssign(&n); },
+        [&](FuncDeclNode &n) { return analyzeFuncDecl(&n); },
+        [&](BinaryOpNode &n) { return analyzeBinary(&n); },
+        [&](UnaryOpNode &n) { return analyzeUnary(&n); },
+        [&](VarNode &n) { return analyzeVar(&n); },
+        [&](FuncCallNode &n) { return analyzeFuncCall(&n); },
+        [&](NumberNode &n) { return analyzeNumber(&n); }
+    });
 
-    return Type::UNKNOWN;
+    node->type = result;
+    return result;
 }
 
 Type SemanticAnalyzer::analyzeAssign(AssignNode *n) {
     Type exprType = analyzeNode(n->expr);
-    declareVariable(n->name, exprType);
+    n->slot = declareVariable(n->name, exprType);
     
     return exprType;
 }
 
 Type SemanticAnalyzer::analyzeFuncDecl(FuncDeclNode *n) {
     pushScope();
+    uint32_t savedBase = frameBase;
+    uint32_t savedTemps = tempCount;
 
-    std::unordered_map<std::string, bool> seen;
-    for (const std::string &p : n->params) {
+    std::unordered_map<Symbol, bool> seen;
+    for (size_t i = 0; i < n->params.size(); ++i) {
+        Symbol p = n->params[i];
         if (seen.count(p)) {
-            throw SemanticError("parâmetro duplicado '" + p + "' na função '" + n->name + "'");
+            throw SemanticError("parâmetro duplicado '" + std::string(Symbols::name(p)) + "' na função '" +
+                                std::string(Symbols::name(n->name)) + "'");
         }
         seen[p] = true;
-        declareVariable(p, Type::UNKNOWN);
+        declareParameter(p, static_cast<uint32_t>(i));
     }
 
+    frameBase = static_cast<uint32_t>(n->params.size());
+    tempCount = 0;
+
     Type returnType = analyzeNode(n->body);
-    
+    n->frameSize = frameBase + tempCount;
 
+    frameBase = savedBase;
+    tempCount = savedTemps;
     popScope();
     return returnType;
 }
@@ -114,23 +165,31 @@ Type SemanticAnalyzer::analyzeBinary(BinaryOpNode *n) {
     Type rightType = analyzeNode(n->right);
     
     Type resultType = checkBinaryOpTypes(n->op, leftType, rightType);
+    n->slot = allocateTemp();
     
     return resultType;
 }
 
+Type SemanticAnalyzer::analyzeUnary(UnaryOpNode *n) {
+    Type operandType = analyzeNode(n->operand);
+    n->slot = allocateTemp();
+    return operandType;
+}
+
 Type SemanticAnalyzer::analyzeVar(VarNode *n) {
     if (!isVariableDeclared(n->name)) {
-        throw SemanticError("variável '" + n->name + "' não declarada.");
+        throw SemanticError("variável '" + std::string(Symbols::name(n->name)) + "' não declarada.");
     }
     
     Type varType = getVariableType(n->name);
+    n->slot = getVariableSlot(n->name);
     
     return varType;
 }
 
 Type SemanticAnalyzer::analyzeFuncCall(FuncCallNode *n) {
     if (!isFunctionDeclared(n->name)) {
-        throw SemanticError("função '" + n->name + "' não declarada.");
+        throw SemanticError("função '" + std::string(Symbols::name(n->name)) + "' não declarada.");
     }
 
     FunctionInfo funcInfo = getFunctionInfo(n->name);
@@ -138,7 +197,7 @@ Type SemanticAnalyzer::analyzeFuncCall(FuncCallNode *n) {
     int received = static_cast<int>(n->args.size());
 
     if (expected != received) {
-        throw SemanticError("função '" + n->name + "' esperava " +
+        throw SemanticError("função '" + std::string(Symbols::name(n->name)) + "' esperava " +
                            std::to_string(expected) + " argumentos, recebeu " +
                            std::to_string(received) + ".");
     }
@@ -147,6 +206,7 @@ Type SemanticAnalyzer::analyzeFuncCall(FuncCallNode *n) {
     for (auto &arg : n->args) {
         analyzeNode(arg);
     }
+    n->slot = allocateTemp();
 
     
     return funcInfo.returnType;
@@ -157,14 +217,14 @@ Type SemanticAnalyzer::analyzeNumber(const NumberNode *n) {
     return n->type;
 }
 
-Type SemanticAnalyzer::checkBinaryOpTypes(const std::string &op, Type left, Type right) {
+Type SemanticAnalyzer::checkBinaryOpTypes(Operator op, Type left, Type right) {
     
     if (left == Type::UNKNOWN || right == Type::UNKNOWN) {
         return Type::UNKNOWN;
     }
     
     
-    if (op == "+" || op == "-" || op == "*" || op == "/" || op == "^") {
+    if (op != Operator::NONE) {
         if (left == Type::FLOAT || right == Type::FLOAT) {
             return Type::FLOAT;
         }
@@ -177,12 +237,271 @@ Type SemanticAnalyzer::checkBinaryOpTypes(const std::string &op, Type left, Type
 void SemanticAnalyzer::analyze(std::vector<NodePtr> &ast) {
     
     for (const auto &node : ast) {
-        if (auto f = dynamic_cast<const FuncDeclNode*>(node.get())) {
+        if (auto f = nodeAs<FuncDeclNode>(node.get())) {
             registerFunction(f);
         }
     }
+    if (functions.size() >= PARALLEL_MIN_FUNCTIONS && ThreadPool::resolveThreads(threads) > 1) {
+        analyzeParallel(ast);
+        return;
+    }
 
     for (auto &node : ast) {
         analyzeNode(node);
     }
-}
\ No newline at end of file
+    mainFrameSize = tempCount;
+}
+
+// Os comandos de topo são analisados em série, gravando a linha do tempo das
+// globais; as declarações de função ficam para o pool, em faixas contíguas,
+// cada faixa com um analisador próprio (escopos, frame e temporários). Os
+// corpos só leem globais e o registro de funções, então nada é compartilhado
+// para escrita. Se houver erros, vale o do comando mais cedo, como na série.
+void SemanticAnalyzer::analyzeParallel(std::vector<NodePtr> &ast) {
+    std::vector<uint32_t> decls;
+    uint32_t failedAt = static_cast<uint32_t>(ast.size());
+    std::exception_ptr failure;
+
+    recording = true;
+    for (uint32_t i = 0; i < ast.size(); ++i) {
+        if (ast[i] && ast[i]->kind == NodeKind::FUNC_DECL) {
+            decls.push_back(i);
+            continue;
+        }
+        position = i;
+        try {
+            analyzeNode(ast[i]);
+        } catch (...) {
+            failedAt = i;
+            failure = std::current_exception();
+            break;
+        }
+    }
+    recording = false;
+    mainFrameSize = tempCount;
+
+    ThreadPool pool(threads);
+    size_t chunks = std::min(decls.size(), pool.size() * 4);
+    std::vector<uint32_t> chunkFailedAt(chunks, failedAt);
+    std::vector<std::exception_ptr> chunkFailure(chunks);
+    std::vector<size_t> chunkLookups(chunks, 0);
+
+    for (size_t c = 0; c < chunks; ++c) {
+        pool.submit([&, c] {
+            SemanticAnalyzer worker(this);
+            size_t end = decls.size() * (c + 1) / chunks;
+            for (size_t k = decls.size() * c / chunks; k < end && decls[k] < failedAt; ++k) {
+                worker.position = decls[k];
+                try {
+                    worker.analyzeNode(ast[decls[k]]);
+                } catch (...) {
+                    chunkFailedAt[c] = decls[k];
+                    chunkFailure[c] = std::current_exception();
+                    break;
+                }
+            }
+            chunkLookups[c] = worker.lookups;
+        });
+    }
+    pool.wait();
+
+    timeline.clear();
+    for (size_t c = 0; c < chunks; ++c) {
+        lookups += chunkLookups[c];
+        if (chunkFailure[c] && chunkFailedAt[c] < failedAt) {
+            failedAt = chunkFailedAt[c];
+            failure = chunkFailure[c];
+        }
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+void SemanticAnalyzer::analyzeStatement(NodePtr &node) {
+    if (!node) return;
+    frameBase = 0;
+    tempCount = 0;
+
+    auto decl = nodeAs<FuncDeclNode>(node.get());
+    auto previous = decl ? functions.find(decl->name) : functions.end();
+    bool redefined = previous != functions.end();
+    FunctionInfo saved = redefined ? previous->second : FunctionInfo{};
+    if (redefined) functions.erase(previous);
+
+    try {
+        if (decl) registerFunction(decl);
+        analyzeNode(node);
+    } catch (...) {
+        variableScopes.resize(1);
+        if (decl) functions.erase(decl->name);
+        if (redefined) functions[decl->name] = saved;
+        throw;
+    }
+    mainFrameSize = tempCount;
+}
+
+void SemanticAnalyzer::registerFunction(const FlatAst &ast, uint32_t decl) {
+    Symbol name = ast.a[decl];
+    if (functions.count(name)) {
+        throw SemanticError("função '" + std::string(Symbols::name(name)) + "' já declarada.");
+    }
+
+    uint32_t list = ast.b[decl];
+    uint32_t count = ast.lists[list];
+    uint32_t body = ast.lists[list + count + 1];
+
+    Type returnType = Type::UNKNOWN;
+    if (ast.kinds[body] == FlatKind::NUMBER) {
+        returnType = ast.types[body];
+    } else if (ast.kinds[body] == FlatKind::VAR) {
+        returnType = getVariableType(ast.a[body]);
+    }
+
+    functions[name] = FunctionInfo{nullptr, static_cast<int>(count), returnType};
+}
+
+void SemanticAnalyzer::analyzeFlatDecl(FlatAst &ast, const FlatStatement &st) {
+    uint32_t decl = st.first;
+    Symbol name = ast.a[decl];
+    uint32_t list = ast.b[decl];
+    uint32_t count = ast.lists[list];
+
+    pushScope();
+    uint32_t savedBase = frameBase;
+    uint32_t savedTemps = tempCount;
+
+    std::unordered_map<Symbol, bool> seen;
+    for (uint32_t i = 0; i < count; ++i) {
+        Symbol p = ast.lists[list + 1 + i];
+        if (seen.count(p)) {
+            throw SemanticError("parâmetro duplicado '" + std::string(Symbols::name(p)) + "' na função '" +
+                                std::string(Symbols::name(name)) + "'");
+        }
+        seen[p] = true;
+        declareParameter(p, i);
+    }
+
+    frameBase = count;
+    tempCount = 0;
+
+    analyzeFlatRange(ast, st.first + 1, st.last);
+    ast.types[decl] = ast.types[st.last];
+    ast.slotIndices[decl] = frameBase + tempCount;
+
+    frameBase = savedBase;
+    tempCount = savedTemps;
+    popScope();
+}
+
+// A árvore confere nome e aridade de uma chamada antes de analisar os
+// argumentos, mas na pós-ordem eles vêm antes do nó CALL. Para dar o mesmo
+// primeiro erro, cada chamada é conferida quando a sua subárvore começa;
+// chamadas aninhadas que começam no mesmo nó vão da mais externa (índice
+// maior) para a mais interna.
+void SemanticAnalyzer::analyzeFlatRange(FlatAst &ast, uint32_t first, uint32_t last) {
+    flatStarts.resize(last - first + 1);
+    flatCalls.clear();
+    for (uint32_t node = first; node <= last; ++node) {
+        uint32_t start = node;
+        switch (ast.kinds[node]) {
+            case FlatKind::BINARY:
+            case FlatKind::UNARY:
+                start = flatStarts[ast.a[node] - first];
+                break;
+            case FlatKind::ASSIGN:
+                start = flatStarts[ast.b[node] - first];
+                break;
+            case FlatKind::CALL: {
+                uint32_t list = ast.b[node];
+                if (ast.lists[list] > 0) start = flatStarts[ast.lists[list + 1] - first];
+                flatCalls.push_back(node);
+                break;
+            }
+            default:
+                break;
+        }
+        flatStarts[node - first] = start;
+    }
+    std::sort(flatCalls.begin(), flatCalls.end(), [&](uint32_t x, uint32_t y) {
+        uint32_t startX = flatStarts[x - first];
+        uint32_t startY = flatStarts[y - first];
+        return startX != startY ? startX < startY : x > y;
+    });
+
+    size_t next = 0;
+    for (uint32_t node = first; node <= last; ++node) {
+        for (; next < flatCalls.size() && flatStarts[flatCalls[next] - first] == node; ++next) {
+            checkFlatCall(ast, flatCalls[next]);
+        }
+        analyzeFlatNode(ast, node);
+    }
+}
+
+void SemanticAnalyzer::checkFlatCall(const FlatAst &ast, uint32_t node) {
+    Symbol name = ast.a[node];
+    if (!isFunctionDeclared(name)) {
+        throw SemanticError("função '" + std::string(Symbols::name(name)) + "' não declarada.");
+    }
+
+    int expected = getFunctionInfo(name).paramCount;
+    int received = static_cast<int>(ast.lists[ast.b[node]]);
+    if (expected != received) {
+        throw SemanticError("função '" + std::string(Symbols::name(name)) + "' esperava " +
+                           std::to_string(expected) + " argumentos, recebeu " +
+                           std::to_string(received) + ".");
+    }
+}
+
+void SemanticAnalyzer::analyzeFlatNode(FlatAst &ast, uint32_t node) {
+    switch (ast.kinds[node]) {
+        case FlatKind::NUMBER:
+            break;
+        case FlatKind::VAR: {
+            Symbol name = ast.a[node];
+            if (!isVariableDeclared(name)) {
+                throw SemanticError("variável '" + std::string(Symbols::name(name)) + "' não declarada.");
+            }
+            ast.types[node] = getVariableType(name);
+            ast.setSlot(node, getVariableSlot(name));
+            break;
+        }
+        case FlatKind::BINARY:
+            ast.types[node] = checkBinaryOpTypes(ast.ops[node],
+                                                 ast.types[ast.a[node]], ast.types[ast.b[node]]);
+            ast.setSlot(node, allocateTemp());
+            break;
+        case FlatKind::UNARY:
+            ast.types[node] = ast.types[ast.a[node]];
+            ast.setSlot(node, allocateTemp());
+            break;
+        case FlatKind::CALL: {
+            // nome e aridade já conferidos em analyzeFlatRange
+            FunctionInfo funcInfo = getFunctionInfo(ast.a[node]);
+            ast.types[node] = funcInfo.returnType;
+            ast.setSlot(node, allocateTemp());
+            break;
+        }
+        case FlatKind::ASSIGN: {
+            Type exprType = ast.types[ast.b[node]];
+            ast.types[node] = exprType;
+            ast.setSlot(node, declareVariable(ast.a[node], exprType));
+            break;
+        }
+        case FlatKind::FUNC_DECL:
+            break;
+    }
+}
+
+void SemanticAnalyzer::analyze(FlatAst &ast) {
+    for (const auto &st : ast.statements) {
+        if (ast.kinds[st.first] == FlatKind::FUNC_DECL) registerFunction(ast, st.first);
+    }
+
+    for (const auto &st : ast.statements) {
+        if (ast.kinds[st.first] == FlatKind::FUNC_DECL) {
+            analyzeFlatDecl(ast, st);
+        } else {
+            analyzeFlatRange(ast, st.first, st.last);
+        }
+    }
+    mainFrameSize = tempCount;
+}
@@ -0,0 +1,207 @@
+#include "../include/session.h"
+#include "../include/lexer.h"
+#include "../include/parser.h"
+#include "../include/trace.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+Session::Session() : interpreter(Program()), clock(0), recomputed(0) {
+    codegen.setIrOptimization(false);
+}
+
+void Session::submit(std::string_view line) {
+    recomputed = 0;
+    std::vector<NodePtr> statements;
+    try {
+        Lexer lexer(arena.copy(line));
+        Parser parser(lexer, arena);
+        statements = parser.parseAll();
+    } catch (const std::exception &e) {
+        Trace::out().flush();
+        std::cerr << "Erro de parser: " << e.what() << "\n";
+        return;
+    }
+
+    for (auto &node : statements) {
+        try {
+            apply(node);
+        } catch (const std::exception &e) {
+            Trace::out().flush();
+            std::cerr << e.what() << "\n";
+        }
+    }
+    Trace::out().flush();
+}
+
+void Session::apply(NodePtr &node) {
+    if (!node) return;
+    auto decl = nodeAs<FuncDeclNode>(node.get());
+    auto assign = nodeAs<AssignNode>(node.get());
+
+    if (decl) checkCallers(decl);
+    sem.analyzeStatement(node);
+
+    // expressão solta: só mostra o valor, não entra no grafo
+    if (!decl && !assign) {
+        run(codegen.generateStatement(node.get()));
+        return;
+    }
+
+    Key key = decl ? functionKey(decl->name) : globalKey(assign->name);
+    bool again = definitions.count(key) != 0;
+    Definition &def = definitions[key];
+    link(key, def, node.get());
+    def.order = ++clock;
+
+    if (decl) {
+        uint32_t index = codegen.generateFunction(decl);
+        interpreter.setFunction(index, codegen.getProgram().functions[index]);
+        if (Trace::enabled(Trace::SUMMARY)) {
+            Trace::out() << "função " << Symbols::name(decl->name)
+                         << (again ? " redefinida\n" : " definida\n");
+        }
+    } else {
+        def.global = assign->slot.index;
+        def.code = codegen.generateStatement(node.get());
+        run(def.code);
+        report(def, assign->name, false);
+    }
+
+    recompute(key);
+}
+
+// Uma função redefinida não pode mudar de aridade enquanto alguém a chama
+// com a aridade antiga: o código de quem chama não é gerado de novo.
+void Session::checkCallers(const FuncDeclNode *decl) const {
+    Key key = functionKey(decl->name);
+    auto it = users.find(key);
+    if (it == users.end()) return;
+
+    uint32_t arity = static_cast<uint32_t>(decl->params.size());
+    for (Key user : it->second) {
+        if (user == key) continue;
+        for (const auto &[callee, argc] : definitions.at(user).calls) {
+            if (callee != decl->name || argc == arity) continue;
+            throw SemanticError("função '" + std::string(Symbols::name(decl->name)) +
+                                "' é chamada por '" + std::string(Symbols::name(static_cast<Symbol>(user >> 1))) +
+                                "' com " +
+                                std::to_string(argc) + " argumentos");
+        }
+    }
+}
+
+// Troca as arestas antigas da definição pelas lidas do novo comando. Uma
+// atribuição que lê a própria variável (x = x + 1) usa o valor anterior e
+// não vira dependente de si mesma.
+void Session::link(Key key, Definition &def, const Node *node) {
+    for (Key read : def.reads) users[read].erase(key);
+    if (isFunction(key)) users[key].erase(key);
+    def.reads.clear();
+    def.calls.clear();
+
+    std::function<void(const Node&)> collect = [&](const Node &n) {
+        Key read = key;
+        if (auto var = nodeAs<VarNode>(&n)) {
+            if (var->slot.kind == SlotKind::GLOBAL) read = globalKey(var->name);
+        } else if (auto call = nodeAs<FuncCallNode>(&n)) {
+            read = functionKey(call->name);
+            def.calls.emplace_back(call->name, static_cast<uint32_t>(call->args.size()));
+        }
+        if (read != key &&
+            std::find(def.reads.begin(), def.reads.end(), read) == def.reads.end()) {
+            def.reads.push_back(read);
+        }
+        forEachChild(n, [&](const NodePtr &child) { collect(*child); });
+    };
+    if (auto decl = nodeAs<FuncDeclNode>(node)) {
+        if (decl->body) collect(*decl->body);
+    } else if (auto assign = nodeAs<AssignNode>(node)) {
+        if (assign->expr) collect(*assign->expr);
+    }
+
+    // chamada recursiva: não conta para a ordem, mas entra na checagem de aridade
+    for (const auto &[callee, argc] : def.calls) {
+        if (functionKey(callee) == key) users[key].insert(key);
+    }
+    for (Key read : def.reads) users[read].insert(key);
+}
+
+// Recalcula as atribuições alcançáveis a partir de `changed` pelas arestas
+// de uso, cada uma uma vez, em ordem topológica do subgrafo afetado. Entre
+// as prontas, vai a definida há mais tempo; num ciclo (x lê f, f lê x) a
+// ordem é quebrada pela mais antiga.
+void Session::recompute(Key changed) {
+    std::vector<Key> affected;
+    std::unordered_map<Key, uint32_t> pending;
+    std::vector<Key> stack{changed};
+    while (!stack.empty()) {
+        Key key = stack.back();
+        stack.pop_back();
+        auto it = users.find(key);
+        if (it == users.end()) continue;
+        for (Key user : it->second) {
+            if (user == changed || pending.count(user)) continue;
+            pending[user] = 0;
+            affected.push_back(user);
+            stack.push_back(user);
+        }
+    }
+    if (affected.empty()) return;
+
+    for (Key key : affected) {
+        for (Key read : definitions.at(key).reads) {
+            if (pending.count(read)) ++pending[key];
+        }
+    }
+
+    using Ready = std::pair<uint64_t, Key>;
+    std::priority_queue<Ready, std::vector<Ready>, std::greater<Ready>> ready;
+    for (Key key : affected) {
+        if (pending[key] == 0) ready.push({definitions.at(key).order, key});
+    }
+
+    std::unordered_set<Key> done;
+    while (done.size() < affected.size()) {
+        if (ready.empty()) {
+            Key oldest = 0;
+            uint64_t order = UINT64_MAX;
+            for (Key key : affected) {
+                if (!done.count(key) && definitions.at(key).order < order) {
+                    order = definitions.at(key).order;
+                    oldest = key;
+                }
+            }
+            ready.push({order, oldest});
+        }
+
+        Key key = ready.top().second;
+        ready.pop();
+        if (!done.insert(key).second) continue;
+
+        const Definition &def = definitions.at(key);
+        if (!isFunction(key)) {
+            run(def.code);
+            report(def, static_cast<Symbol>(key >> 1), true);
+            ++recomputed;
+        }
+        for (Key user : users[key]) {
+            auto it = pending.find(user);
+            if (it != pending.end() && it->second > 0 && --it->second == 0) {
+                ready.push({definitions.at(user).order, user});
+            }
+        }
+    }
+}
+
+void Session::run(const FunctionCode &code) {
+    interpreter.syncData(codegen.getProgram());
+    interpreter.runStatement(code);
+}
+
+void Session::report(const Definition &def, Symbol name, bool again) const {
+    if (!Trace::enabled(Trace::SUMMARY)) return;
+    Trace::out() << Symbols::name(name) << " = " << interpreter.getGlobals()[def.global]
+                 << (again ? "  (recalculada)\n" : "\n");
+}
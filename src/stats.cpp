@@ -0,0 +1,171 @@
+#include "../include/stats.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define MC_HAS_RUSAGE 1
+#else
+#define MC_HAS_RUSAGE 0
+#endif
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<bool> counting(false);
+std::atomic<uint64_t> allocCount(0);
+std::atomic<uint64_t> allocBytes(0);
+
+inline void record(std::size_t size) {
+    if (counting.load(std::memory_order_relaxed)) {
+        allocCount.fetch_add(1, std::memory_order_relaxed);
+        allocBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void *allocate(std::size_t size) {
+    record(size);
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void *p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment) {
+    record(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (size == 0) size = 1;
+    for (;;) {
+#ifdef _WIN32
+        void *p = _aligned_malloc(size, align);
+#else
+        void *p = nullptr;
+        if (posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, size) != 0) p = nullptr;
+#endif
+        if (p) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void releaseAligned(void *p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+
+void enableAllocCounting() {
+    counting.store(true);
+}
+
+AllocCounters allocCounters() {
+    return {allocCount.load(std::memory_order_relaxed), allocBytes.load(std::memory_order_relaxed)};
+}
+
+size_t peakMemory() {
+#if MC_HAS_RUSAGE
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+StatsReport::StatsReport(bool enabled) : enabled(enabled) {
+    if (enabled) enableAllocCounting();
+}
+
+void StatsReport::begin() {
+    if (!enabled) return;
+    startedAllocs = allocCounters();
+    started = std::chrono::steady_clock::now();
+}
+
+void StatsReport::end(const char *phase) {
+    if (!enabled) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    AllocCounters now = allocCounters();
+    AllocCounters allocs{now.count - startedAllocs.count, now.bytes - startedAllocs.bytes};
+
+    // a mesma fase medida em trechos (um por arquivo) vira uma linha só
+    for (auto &existing : phases) {
+        if (std::strcmp(existing.name, phase) != 0) continue;
+        existing.seconds += seconds;
+        existing.allocs.count += allocs.count;
+        existing.allocs.bytes += allocs.bytes;
+        return;
+    }
+    phases.push_back({phase, seconds, allocs});
+}
+
+// Completa com espaços até `width` caracteres (não bytes: os nomes têm acentos).
+static std::string padded(const std::string &text, size_t width, bool right) {
+    size_t chars = 0;
+    for (unsigned char c : text) chars += (c & 0xC0) != 0x80;
+    std::string fill(chars < width ? width - chars : 0, ' ');
+    return right ? fill + text : text + fill;
+}
+
+void StatsReport::print(std::ostream &out) const {
+    if (!enabled) return;
+    out << "\n=== ESTATÍSTICAS ===\n"
+        << padded("fase", 12, false) << padded("tempo (ms)", 12, true)
+        << padded("alocações", 12, true) << padded("bytes", 14, true) << "\n";
+
+    Phase total{"total", 0.0, {}};
+    for (const auto &phase : phases) {
+        total.seconds += phase.seconds;
+        total.allocs.count += phase.allocs.count;
+        total.allocs.bytes += phase.allocs.bytes;
+    }
+    auto row = [&](const Phase &phase) {
+        char ms[32];
+        std::snprintf(ms, sizeof(ms), "%.3f", phase.seconds * 1e3);
+        out << padded(phase.name, 12, false) << padded(ms, 12, true)
+            << padded(std::to_string(phase.allocs.count), 12, true)
+            << padded(std::to_string(phase.allocs.bytes), 14, true) << "\n";
+    };
+    for (const auto &phase : phases) row(phase);
+    row(total);
+
+    out << "\ntokens: " << tokens << ", nós da AST: " << nodes << ", instruções: " << instructions << "\n"
+        << "buscas em escopos: " << scopeLookups << "\n"
+        << "instruções despachadas: " << dispatched << ", chamadas: " << calls << "\n";
+    size_t peak = peakMemory();
+    if (peak > 0) out << "pico de memória: " << peak / 1024 << " KiB\n";
+    else out << "pico de memória: indisponível\n";
+}
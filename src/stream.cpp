@@ -0,0 +1,250 @@
+#include "../include/stream.h"
+#include "../include/batch.h"
+#include "../include/mapped_file.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// Um bloco da entrada e o resultado dele. O laço principal preenche a
+// entrada e só volta a olhar o bloco depois que `ready` fica verdadeiro.
+struct Chunk {
+    size_t begin = 0;
+    size_t end = 0;
+    bool ready = false;
+    size_t rows = 0;
+    std::string output;
+    std::exception_ptr error;
+};
+
+inline bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+size_t lineNumber(const char *data, const char *at) {
+    return static_cast<size_t>(std::count(data, at, '\n')) + 1;
+}
+
+// Lê os valores de uma linha; devolve false no primeiro campo inválido.
+bool parseLine(const char *p, const char *end, std::vector<double> &values, const char *&bad) {
+    values.clear();
+    while (true) {
+        while (p < end && isSeparator(*p)) ++p;
+        if (p >= end) return true;
+        if (*p == '+') ++p;
+        double value;
+        auto res = std::from_chars(p, end, value);
+        if (res.ec != std::errc() || (res.ptr < end && !isSeparator(*res.ptr))) {
+            bad = p;
+            return false;
+        }
+        values.push_back(value);
+        p = res.ptr;
+    }
+}
+
+void appendResults(std::string &out, const std::vector<double> &results) {
+    out.reserve(out.size() + results.size() * 12);
+    char buf[32];
+    for (double value : results) {
+        auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, res.ptr);
+        out.push_back('\n');
+    }
+}
+
+}
+
+StreamEvaluator::StreamEvaluator(const Program &prog, const std::vector<double> &g, uint32_t f)
+    : program(prog), globals(g), function(f), arity(prog.functions.at(f).params.size()) {}
+
+StreamStats StreamEvaluator::run(const StreamOptions &options) {
+    auto start = std::chrono::steady_clock::now();
+    const std::string &name = program.functions[function].name;
+    if (arity == 0) {
+        throw std::runtime_error("função '" + name + "' não tem parâmetros para ligar às colunas.");
+    }
+
+    MappedFile input(options.input);
+    std::ofstream output(options.output, std::ios::binary | std::ios::trunc);
+    if (!output) throw std::runtime_error("não foi possível criar '" + options.output + "'");
+
+    const char *data = input.data();
+    size_t size = input.size();
+    bool binary = options.format == StreamFormat::BINARY;
+
+    size_t totalRows = 0;
+    if (binary) {
+        size_t rowBytes = arity * sizeof(double);
+        if (size % rowBytes != 0) {
+            throw std::runtime_error("tamanho de '" + options.input + "' não é múltiplo de " +
+                                     std::to_string(arity) + " colunas de double.");
+        }
+        totalRows = size / rowBytes;
+    }
+
+    ThreadPool pool(options.threads);
+    std::vector<std::unique_ptr<BatchEvaluator>> evaluators;
+    for (size_t i = 0; i < pool.size(); ++i) {
+        evaluators.push_back(std::make_unique<BatchEvaluator>(program, globals));
+    }
+    // valida aridade e recursão antes de começar
+    std::vector<const double*> none(arity, nullptr);
+    evaluators[0]->evaluate(function, none, 0, nullptr);
+
+    size_t window = options.window ? options.window : 4 * pool.size();
+    std::vector<Chunk> chunks(window);
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+
+    auto csvTask = [&](Chunk &chunk) {
+        BatchEvaluator &eval = *evaluators[pool.currentWorker()];
+        std::vector<std::vector<double>> columns(arity);
+        std::vector<double> values;
+        const char *p = data + chunk.begin;
+        const char *end = data + chunk.end;
+
+        while (p < end) {
+            const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
+            const char *bad = nullptr;
+            if (!parseLine(p, lineEnd, values, bad)) {
+                const char *fieldEnd = bad;
+                while (fieldEnd < lineEnd && !isSeparator(*fieldEnd)) ++fieldEnd;
+                throw std::runtime_error("linha " + std::to_string(lineNumber(data, bad)) +
+                                         ": valor inválido '" + std::string(bad, fieldEnd) + "'");
+            }
+            if (!values.empty()) {
+                if (values.size() != arity) {
+                    throw std::runtime_error("linha " + std::to_string(lineNumber(data, p)) +
+                                             ": esperava " + std::to_string(arity) + " valores");
+                }
+                for (size_t i = 0; i < arity; ++i) columns[i].push_back(values[i]);
+            }
+            p = lineEnd + 1;
+        }
+
+        chunk.rows = columns[0].size();
+        std::vector<const double*> inputs;
+        for (const auto &column : columns) inputs.push_back(column.data());
+        std::vector<double> results(chunk.rows);
+        eval.evaluate(function, inputs, chunk.rows, results.data());
+        appendResults(chunk.output, results);
+    };
+
+    // Entrada binária: as colunas são lidas direto do mapeamento, sem cópia.
+    auto binaryTask = [&](Chunk &chunk) {
+        BatchEvaluator &eval = *evaluators[pool.currentWorker()];
+        const double *base = reinterpret_cast<const double *>(data);
+        std::vector<const double*> inputs;
+        for (size_t i = 0; i < arity; ++i) inputs.push_back(base + i * totalRows + chunk.begin);
+
+        chunk.rows = chunk.end - chunk.begin;
+        chunk.output.resize(chunk.rows * sizeof(double));
+        std::vector<double> results(chunk.rows);
+        eval.evaluate(function, inputs, chunk.rows, results.data());
+        std::memcpy(chunk.output.data(), results.data(), chunk.output.size());
+    };
+
+    // Cabeçalho CSV: primeira linha que não começa com número.
+    size_t position = 0;
+    if (!binary && size > 0) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(data, '\n', size));
+        if (!lineEnd) lineEnd = data + size;
+        std::vector<double> values;
+        const char *bad = nullptr;
+        if (!parseLine(data, lineEnd, values, bad) && bad == data + (data[0] == '+')) {
+            position = static_cast<size_t>(lineEnd - data) + (lineEnd < data + size ? 1 : 0);
+        }
+    }
+
+    auto nextChunk = [&](Chunk &chunk) -> bool {
+        if (binary) {
+            if (position >= totalRows) return false;
+            chunk.begin = position;
+            chunk.end = std::min(totalRows, position + options.chunkRows);
+        } else {
+            if (position >= size) return false;
+            chunk.begin = position;
+            chunk.end = std::min(size, position + options.chunkBytes);
+            if (chunk.end < size) {
+                const void *nl = std::memchr(data + chunk.end, '\n', size - chunk.end);
+                chunk.end = nl ? static_cast<size_t>(static_cast<const char *>(nl) - data) + 1 : size;
+            }
+        }
+        position = chunk.end;
+        return true;
+    };
+
+    auto release = [&](const Chunk &chunk) {
+        if (!binary) {
+            input.release(chunk.begin, chunk.end - chunk.begin);
+            return;
+        }
+        for (size_t i = 0; i < arity; ++i) {
+            input.release((i * totalRows + chunk.begin) * sizeof(double),
+                          (chunk.end - chunk.begin) * sizeof(double));
+        }
+    };
+
+    StreamStats stats;
+    stats.threads = pool.size();
+    size_t submitted = 0;
+    size_t written = 0;
+    bool more = true;
+
+    while (true) {
+        while (more && submitted - written < window) {
+            Chunk &chunk = chunks[submitted % window];
+            more = nextChunk(chunk);
+            if (!more) break;
+
+            pool.submit([&, &chunk = chunk] {
+                try {
+                    if (binary) binaryTask(chunk);
+                    else csvTask(chunk);
+                } catch (...) {
+                    chunk.error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(doneMutex);
+                chunk.ready = true;
+                doneCv.notify_all();
+            });
+            ++submitted;
+        }
+        if (written == submitted) break;
+
+        Chunk &chunk = chunks[written % window];
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCv.wait(lock, [&] { return chunk.ready; });
+        }
+        if (chunk.error) {
+            pool.wait();
+            std::rethrow_exception(chunk.error);
+        }
+
+        output.write(chunk.output.data(), static_cast<std::streamsize>(chunk.output.size()));
+        release(chunk);
+        stats.rows += chunk.rows;
+        ++stats.chunks;
+
+        chunk = Chunk();
+        ++written;
+    }
+
+    output.flush();
+    if (!output) throw std::runtime_error("erro ao gravar '" + options.output + "'");
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,76 @@
+#include "../include/symbols.h"
+#include "../include/arena.h"
+#include <vector>
+
+namespace {
+
+// Hash aberto com sondagem linear: o lexer chama intern() para cada
+// identificador do código, então a busca precisa ser barata.
+struct Table {
+    Arena text;
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> hashes;
+    std::vector<Symbol> slots = std::vector<Symbol>(1024, Symbols::NONE);
+};
+
+Table& table() {
+    static Table instance;
+    return instance;
+}
+
+uint32_t hashText(std::string_view text) {
+    uint32_t h = 2166136261u;
+    for (char c : text) h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+    return h;
+}
+
+size_t findSlot(const Table &t, std::string_view text, uint32_t hash) {
+    size_t mask = t.slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Symbol symbol = t.slots[i];
+        if (symbol == Symbols::NONE) return i;
+        if (t.hashes[symbol] == hash && t.names[symbol] == text) return i;
+    }
+}
+
+void grow(Table &t) {
+    std::vector<Symbol> old(t.slots.size() * 2, Symbols::NONE);
+    old.swap(t.slots);
+    size_t mask = t.slots.size() - 1;
+    for (Symbol symbol : old) {
+        if (symbol == Symbols::NONE) continue;
+        size_t i = t.hashes[symbol] & mask;
+        while (t.slots[i] != Symbols::NONE) i = (i + 1) & mask;
+        t.slots[i] = symbol;
+    }
+}
+
+}
+
+Symbol Symbols::intern(std::string_view text) {
+    Table &t = table();
+    uint32_t hash = hashText(text);
+    size_t slot = findSlot(t, text, hash);
+    if (t.slots[slot] != NONE) return t.slots[slot];
+
+    Symbol symbol = static_cast<Symbol>(t.names.size());
+    t.names.push_back(t.text.copy(text));
+    t.hashes.push_back(hash);
+    t.slots[slot] = symbol;
+    // no máximo metade ocupada
+    if (t.names.size() * 2 > t.slots.size()) grow(t);
+    return symbol;
+}
+
+Symbol Symbols::find(std::string_view text) {
+    const Table &t = table();
+    return t.slots[findSlot(t, text, hashText(text))];
+}
+
+std::string_view Symbols::name(Symbol symbol) {
+    return table().names[symbol];
+}
+
+size_t Symbols::count() {
+    return table().names.size();
+}
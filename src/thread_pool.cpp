@@ -0,0 +1,99 @@
+#include "../include/thread_pool.h"
+
+namespace {
+thread_local const ThreadPool *workerPool = nullptr;
+thread_local size_t workerIndex = ThreadPool::NOT_A_WORKER;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+    : queued(0), pending(0), nextQueue(0), stopping(false) {
+    threads = resolveThreads(threads);
+
+    for (size_t i = 0; i < threads; ++i) queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < threads; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) worker.join();
+}
+
+size_t ThreadPool::resolveThreads(size_t threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+}
+
+size_t ThreadPool::currentWorker() const {
+    return workerPool == this ? workerIndex : NOT_A_WORKER;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t index = currentWorker();
+    if (index == NOT_A_WORKER) index = nextQueue++ % queues.size();
+
+    pending.fetch_add(1);
+    {
+        // contado antes de entrar na fila (nunca fica negativo) e sob o mutex,
+        // para que um worker prestes a dormir veja a tarefa nova
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    wakeUp.notify_one();
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()> &task) {
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, std::function<void()> &task) {
+    for (size_t k = 1; k < queues.size(); ++k) {
+        Queue &victim = *queues[(index + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    workerPool = this;
+    workerIndex = index;
+
+    for (;;) {
+        std::function<void()> task;
+        if (popLocal(index, task) || steal(index, task)) {
+            queued.fetch_sub(1);
+            task();
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [&] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
+
+// Espera todas as tarefas submetidas (inclusive as criadas por outras tarefas).
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [&] { return pending.load() == 0; });
+}
@@ -0,0 +1,83 @@
+#include "../include/trace.h"
+#include <iostream>
+#include <sstream>
+
+unsigned Trace::channels = Trace::ALL;
+
+TraceBuffer::TraceBuffer(std::FILE *f) : file(f) {
+    setp(buffer, buffer + CAPACITY);
+}
+
+TraceBuffer::~TraceBuffer() {
+    sync();
+}
+
+TraceBuffer::int_type TraceBuffer::overflow(int_type c) {
+    if (sync() != 0) return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize TraceBuffer::xsputn(const char *s, std::streamsize n) {
+    if (n > epptr() - pptr()) {
+        if (sync() != 0) return 0;
+        // bloco maior que o buffer: vai direto, sem passar pela cópia
+        if (n >= static_cast<std::streamsize>(CAPACITY)) {
+            return static_cast<std::streamsize>(std::fwrite(s, 1, static_cast<size_t>(n), file));
+        }
+    }
+    traits_type::copy(pptr(), s, static_cast<size_t>(n));
+    pbump(static_cast<int>(n));
+    return n;
+}
+
+int TraceBuffer::sync() {
+    size_t pending = static_cast<size_t>(pptr() - pbase());
+    if (pending > 0 && std::fwrite(pbase(), 1, pending, file) != pending) return -1;
+    setp(buffer, buffer + CAPACITY);
+    return std::fflush(file) == 0 ? 0 : -1;
+}
+
+void Trace::setLevel(TraceLevel level) {
+    switch (level) {
+        case TraceLevel::QUIET: channels = 0; break;
+        case TraceLevel::SUMMARY: channels = SUMMARY; break;
+        case TraceLevel::CODE: channels = SUMMARY | LEXER | PARSER | CODEGEN; break;
+        case TraceLevel::FULL: channels = ALL; break;
+    }
+}
+
+bool Trace::parseChannels(const std::string &list, unsigned &mask) {
+    mask = 0;
+    std::istringstream in(list);
+    std::string name;
+    while (std::getline(in, name, ',')) {
+        if (name == "lexer") mask |= LEXER;
+        else if (name == "parser") mask |= PARSER;
+        else if (name == "codegen") mask |= CODEGEN;
+        else if (name == "exec") mask |= EXEC;
+        else if (name == "summary") mask |= SUMMARY;
+        else if (!name.empty()) return false;
+    }
+    return true;
+}
+
+std::ostream& Trace::out() {
+    static TraceBuffer buffer(stdout);
+    static std::ostream stream(&buffer);
+    static bool tied = [] {
+        // erros e leituras do stdin esvaziam o buffer antes, mantendo a ordem
+        std::cerr.tie(&stream);
+        std::cin.tie(&stream);
+        return true;
+    }();
+    (void)tied;
+    return stream;
+}
+
+void Trace::flush() {
+    out().flush();
+}